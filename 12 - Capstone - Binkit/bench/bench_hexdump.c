@@ -0,0 +1,155 @@
+// bench_hexdump.c - block-buffered cmd_hexdump vs the original byte-at-a-time one
+//
+// Build (from "12 - Capstone - Binkit"):
+//   gcc -std=c17 -O2 -Wall -Wextra bench/bench_hexdump.c hexdump.c util.c -o bench_hexdump
+// Run:
+//   ./bench_hexdump [megabytes]      (default 32)
+//
+// Writes a random file, then runs each implementation with stdout pointed at
+// a temp file, times it, and checks both produced the same bytes. The
+// canonical and grouped layouts are timed too (new code only).
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "../binkit.h"
+
+// The v0 implementation, verbatim apart from the name, so there's something
+// fixed to measure against.
+static int legacy_hexdump(int argc, char **argv) {
+    FILE *fp = stdin;                // default: read from standard input
+    unsigned long offset = 0;        // how many bytes we’ve printed so far
+    unsigned char byte;              // one byte buffer
+
+    // If a filename is provided (and not an option), open it.
+    if (argc > 1 && argv[1][0] != '-') {
+        fp = fopen(argv[1], "rb");
+        if (!fp) { perror("fopen"); return 1; }
+    } else if (argc < 1) {
+        fprintf(stderr, "Usage: %s [file]\n", argv[0]);
+        return 1;
+    }
+
+    // Read 1 byte at a time and print it in hex, 16 per line.
+    while (fread(&byte, 1, 1, fp) == 1) {
+        if (offset % 16 == 0) {
+            // Print the starting offset for this row (8 hex digits)
+            printf("%08lX: ", offset);
+        }
+
+        // Print the current byte as two hex digits
+        printf("%02X ", byte);
+
+        // Move to the next byte; if we've printed 16, end the line.
+        offset++;
+        if (offset % 16 == 0) {
+            putchar('\n');
+        }
+    }
+
+    // If we ended mid-row, print a final newline
+    if (offset % 16 != 0) {
+        putchar('\n');
+    }
+
+    if (fp != stdin) fclose(fp);
+    return 0;
+}
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+// Run fn(argc, argv) with stdout redirected into out_path; returns seconds
+static double run(int (*fn)(int, char **), int argc, char **argv, const char *out_path) {
+    fflush(stdout);
+    int saved = dup(STDOUT_FILENO);
+    int fd = open(out_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (saved < 0 || fd < 0) {
+        perror("open");
+        exit(1);
+    }
+    dup2(fd, STDOUT_FILENO);
+    close(fd);
+
+    double t0 = now();
+    int rc = fn(argc, argv);
+    fflush(stdout);
+    double t = now() - t0;
+
+    dup2(saved, STDOUT_FILENO);
+    close(saved);
+    if (rc != 0) {
+        fprintf(stderr, "run failed (%d)\n", rc);
+        exit(1);
+    }
+    return t;
+}
+
+static int same_file(const char *a, const char *b) {
+    FILE *fa = fopen(a, "rb"), *fb = fopen(b, "rb");
+    int same = fa && fb;
+    static char ba[1 << 16], bb[1 << 16];
+    while (same) {
+        size_t na = fread(ba, 1, sizeof ba, fa);
+        size_t nb = fread(bb, 1, sizeof bb, fb);
+        if (na != nb || memcmp(ba, bb, na) != 0) same = 0;
+        if (na == 0) break;
+    }
+    if (fa) fclose(fa);
+    if (fb) fclose(fb);
+    return same;
+}
+
+int main(int argc, char **argv) {
+    size_t mb = argc > 1 ? strtoul(argv[1], NULL, 10) : 32;
+    if (mb == 0) mb = 32;
+    const char *in_path = "/tmp/bench_hexdump.in";
+    const char *old_out = "/tmp/bench_hexdump.old";
+    const char *new_out = "/tmp/bench_hexdump.new";
+
+    FILE *f = fopen(in_path, "wb");
+    if (!f) {
+        perror("fopen");
+        return 1;
+    }
+    srand(42);
+    static unsigned char chunk[1 << 20];
+    for (size_t i = 0; i < mb; i++) {
+        for (size_t j = 0; j < sizeof chunk; j++) chunk[j] = (unsigned char)rand();
+        fwrite(chunk, 1, sizeof chunk, f);
+    }
+    fclose(f);
+
+    char *args[] = { "hexdump", (char *)in_path, NULL };
+    double t_old = run(legacy_hexdump, 2, args, old_out);
+    double t_new = run(cmd_hexdump, 2, args, new_out);
+    int same = same_file(old_out, new_out);
+
+    printf("%zu MB input\n", mb);
+    printf("%-22s %8.3f s %9.1f MB/s\n", "legacy (fread+printf)", t_old, (double)mb / t_old);
+    printf("%-22s %8.3f s %9.1f MB/s  (%.1fx, output %s)\n", "block + tables", t_new,
+           (double)mb / t_new, t_old / t_new, same ? "identical" : "DIFFERS");
+
+    char *canon[] = { "hexdump", (char *)in_path, "--canonical", NULL };
+    double t = run(cmd_hexdump, 3, canon, new_out);
+    printf("%-22s %8.3f s %9.1f MB/s\n", "--canonical", t, (double)mb / t);
+
+    char *grouped[] = { "hexdump", (char *)in_path, "--width", "32", "--group", "4", NULL };
+    t = run(cmd_hexdump, 6, grouped, new_out);
+    printf("%-22s %8.3f s %9.1f MB/s\n", "--width 32 --group 4", t, (double)mb / t);
+
+    char *generic[] = { "hexdump", (char *)in_path, "--width", "24", "--group", "3", NULL };
+    t = run(cmd_hexdump, 6, generic, new_out);
+    printf("%-22s %8.3f s %9.1f MB/s\n", "--width 24 --group 3", t, (double)mb / t);
+
+    unlink(in_path);
+    unlink(old_out);
+    unlink(new_out);
+    return same ? 0 : 1;
+}
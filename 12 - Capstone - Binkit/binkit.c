@@ -0,0 +1,55 @@
+// binkit.c - front door: picks the subcommand and hands it the rest of argv
+//
+// Build:
+//   gcc -std=c17 -Wall -Wextra -O2 -pthread binkit.c hexdump.c entropy.c strings.c identify.c carve.c sigs.c util.c -o binkit -lm
+//
+//   ./binkit hexdump [file] [options]
+//   ./binkit entropy [file] [--window N] [--step N] [--block N]
+//   ./binkit strings [file] [-n MIN] [--utf16]
+//   ./binkit identify [path...] [-j N] [--summary]
+//   ./binkit carve IMAGE [-o DIR] [-j N]
+//   ./binkit file.bin            (no subcommand = hexdump, like the v0 tool)
+#include <stdio.h>
+#include <string.h>
+#include "binkit.h"
+
+struct command {
+    const char *name;
+    int (*run)(int argc, char **argv);
+    const char *help;
+};
+
+static const struct command commands[] = {
+    { "hexdump", cmd_hexdump, "dump bytes as hex rows" },
+    { "entropy", cmd_entropy, "Shannon entropy per block (spot packed/encrypted data)" },
+    { "strings", cmd_strings, "printable text runs (ASCII, optionally UTF-16LE) with offsets" },
+    { "identify", cmd_identify, "file types under a directory, from their leading bytes" },
+    { "carve", cmd_carve, "find (and extract) JPEG/PNG/ZIP/PDF/ELF files inside an image" },
+};
+
+static void usage(const char *prog) {
+    fprintf(stderr, "Usage: %s <command> [args]\n", prog);
+    fprintf(stderr, "       %s [file]   (same as: %s hexdump [file])\n\n", prog, prog);
+    for (size_t i = 0; i < sizeof commands / sizeof commands[0]; i++) {
+        fprintf(stderr, "  %-10s %s\n", commands[i].name, commands[i].help);
+    }
+}
+
+int main(int argc, char **argv) {
+    if (argc > 1 && (strcmp(argv[1], "-h") == 0 || strcmp(argv[1], "--help") == 0)) {
+        usage(argv[0]);
+        return 0;
+    }
+
+    if (argc > 1) {
+        for (size_t i = 0; i < sizeof commands / sizeof commands[0]; i++) {
+            if (strcmp(argv[1], commands[i].name) == 0) {
+                return commands[i].run(argc - 1, argv + 1);
+            }
+        }
+    }
+
+    // Anything else (a filename, an option, or nothing at all) goes to
+    // hexdump with argv untouched, so "./binkit file.bin" keeps working.
+    return cmd_hexdump(argc, argv);
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+// Each subcommand gets argv starting at its own name (argv[0] = "hexdump"),
+// and returns the process exit status.
+int cmd_hexdump(int argc, char **argv);
+int cmd_entropy(int argc, char **argv);
+int cmd_strings(int argc, char **argv);
+int cmd_identify(int argc, char **argv);
+int cmd_carve(int argc, char **argv);
@@ -0,0 +1,519 @@
+#define _GNU_SOURCE                 // copy_file_range
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "binkit.h"
+#include "sigs.h"
+#include "util.h"
+
+// binkit carve: find files embedded in a raw disk image (or memory dump,
+// firmware blob, ...) by their header and footer bytes, and optionally copy
+// them out.
+//
+//   * One pass finds every header and footer: all patterns go into one
+//     Aho-Corasick automaton (sig_ac_* in sigs.c).
+//   * The image is mmapped and cut into chunks that worker threads scan in
+//     parallel. Each chunk is scanned a little past its end (longest pattern
+//     - 1 bytes) so a signature straddling the cut is still seen, but only
+//     matches that *start* inside the chunk count, so nothing is found twice.
+//   * Pairing headers with footers happens afterwards on the sorted hits.
+//   * -o DIR copies each file out with copy_file_range(), so the kernel moves
+//     the bytes (or shares extents, on filesystems that can) instead of
+//     pulling them through our address space.
+
+enum {
+    CHUNK = 64 << 20,
+    MAX_THREADS = 256,
+};
+
+enum ftype { T_JPEG, T_PNG, T_ZIP, T_PDF, T_ELF, NTYPES };
+
+// How each type ends:
+//   JPEG  first FF D9 (end-of-image marker) after the start of the image
+//         data (see jpeg_data_start)
+//   PNG   first IEND chunk (type + CRC) after the header
+//   ZIP   first end-of-central-directory record, plus its comment
+//   PDF   last %%EOF before the next PDF header (incremental saves append
+//         more %%EOFs, so the first one can be too early)
+//   ELF   no footer: size comes from the program/section header tables
+static const struct {
+    const char *ext;
+    const char *header;
+    const char *footer;         // NULL = size from the header
+    uint64_t max_size;          // give up looking for a footer past this
+} types[NTYPES] = {
+    [T_JPEG] = { "jpg", "FF D8 FF",                "FF D9",                   32ULL << 20 },
+    [T_PNG]  = { "png", "89 50 4E 47 0D 0A 1A 0A", "49 45 4E 44 AE 42 60 82", 64ULL << 20 },
+    [T_ZIP]  = { "zip", "50 4B 03 04",             "50 4B 05 06",             1ULL << 30 },
+    [T_PDF]  = { "pdf", "25 50 44 46 2D",          "25 25 45 4F 46",          256ULL << 20 },
+    [T_ELF]  = { "elf", "7F 45 4C 46",             NULL,                      1ULL << 30 },
+};
+
+// Automaton pattern k: type k / 2, header when k is even, footer when odd
+#define PAT_HEADER(t) (2 * (t))
+#define PAT_FOOTER(t) (2 * (t) + 1)
+
+struct hit {
+    uint64_t off;
+    int pat;
+};
+
+struct hitvec {
+    struct hit *v;
+    size_t n, cap;
+};
+
+struct chunk {
+    uint64_t start, end;        // matches must start in [start, end)
+    struct hitvec hits;
+    int failed;
+};
+
+struct scan_pool {
+    pthread_mutex_t mu;
+    size_t next, nchunks;
+    struct chunk *chunks;
+    const unsigned char *map;
+    uint64_t len;
+    const struct sig_ac *ac;
+    size_t overlap;
+};
+
+struct scan_ctx {
+    struct chunk *c;
+    uint64_t base;              // image offset of the scanned buffer's byte 0
+};
+
+static void collect(void *arg, size_t pattern, size_t start) {
+    struct scan_ctx *ctx = arg;
+    struct chunk *c = ctx->c;
+    uint64_t off = ctx->base + start;
+    if (off >= c->end || c->failed) return; // the next chunk owns it
+    struct hitvec *h = &c->hits;
+    if (h->n == h->cap) {
+        size_t cap = h->cap ? h->cap * 2 : 256;
+        struct hit *bigger = realloc(h->v, cap * sizeof *bigger);
+        if (!bigger) { c->failed = 1; return; }
+        h->v = bigger;
+        h->cap = cap;
+    }
+    h->v[h->n++] = (struct hit){ off, (int)pattern };
+}
+
+static void *scan_worker(void *arg) {
+    struct scan_pool *p = arg;
+    for (;;) {
+        pthread_mutex_lock(&p->mu);
+        size_t i = p->next < p->nchunks ? p->next++ : p->nchunks;
+        pthread_mutex_unlock(&p->mu);
+        if (i == p->nchunks) return NULL;
+
+        struct chunk *c = &p->chunks[i];
+        uint64_t stop = c->end + p->overlap < p->len ? c->end + p->overlap : p->len;
+        struct scan_ctx ctx = { c, c->start };
+        sig_ac_scan(p->ac, p->map + c->start, (size_t)(stop - c->start), collect, &ctx);
+    }
+}
+
+// --- pairing ---
+
+struct offsets {
+    uint64_t *v;
+    size_t n;
+};
+
+struct item {
+    uint64_t start, end;        // end == 0: couldn't tell where it ends
+    enum ftype type;
+};
+
+// First offset >= x, as an index (== n when there's none)
+static size_t lower_bound(const struct offsets *o, uint64_t x) {
+    size_t lo = 0, hi = o->n;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (o->v[mid] < x) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+static uint64_t rd(const unsigned char *p, int size, int big) {
+    uint64_t v = 0;
+    for (int i = 0; i < size; i++) {
+        int k = big ? i : size - 1 - i;
+        v = v << 8 | p[k];
+    }
+    return v;
+}
+
+// Where an ELF file ends: the furthest of its header tables and segments.
+// 0 when the header doesn't look like a real ELF (the 4 magic bytes alone
+// turn up in plenty of non-ELF data).
+static uint64_t elf_size(const unsigned char *p, uint64_t avail) {
+    if (avail < 64) return 0;
+    int is64 = p[4] == 2, big = p[5] == 2;
+    if ((p[4] != 1 && p[4] != 2) || (p[5] != 1 && p[5] != 2) || p[6] != 1) return 0;
+
+    uint64_t phoff, shoff, ehsize, phentsize, phnum, shentsize, shnum;
+    if (is64) {
+        phoff = rd(p + 32, 8, big);
+        shoff = rd(p + 40, 8, big);
+        ehsize = rd(p + 52, 2, big);
+        phentsize = rd(p + 54, 2, big);
+        phnum = rd(p + 56, 2, big);
+        shentsize = rd(p + 58, 2, big);
+        shnum = rd(p + 60, 2, big);
+    } else {
+        phoff = rd(p + 28, 4, big);
+        shoff = rd(p + 32, 4, big);
+        ehsize = rd(p + 40, 2, big);
+        phentsize = rd(p + 42, 2, big);
+        phnum = rd(p + 44, 2, big);
+        shentsize = rd(p + 46, 2, big);
+        shnum = rd(p + 48, 2, big);
+    }
+    if (ehsize != (is64 ? 64u : 52u)) return 0;
+    if (phnum && phentsize != (is64 ? 56u : 32u)) return 0;
+    if (shnum && shentsize != (is64 ? 64u : 40u)) return 0;
+    // offsets past 1 TiB are garbage, and keep the sums below from overflowing
+    if (phoff > (1ULL << 40) || shoff > (1ULL << 40)) return 0;
+
+    uint64_t end = ehsize;
+    if (phnum) {
+        uint64_t t = phoff + phnum * phentsize;
+        if (t > end) end = t;
+        for (uint64_t i = 0; i < phnum && phoff + (i + 1) * phentsize <= avail; i++) {
+            const unsigned char *ph = p + phoff + i * phentsize;
+            uint64_t off = is64 ? rd(ph + 8, 8, big) : rd(ph + 4, 4, big);
+            uint64_t filesz = is64 ? rd(ph + 32, 8, big) : rd(ph + 16, 4, big);
+            if (off > (1ULL << 40) || filesz > (1ULL << 40)) return 0;
+            if (off + filesz > end) end = off + filesz;
+        }
+    }
+    if (shnum) {
+        uint64_t t = shoff + shnum * shentsize;
+        if (t > end) end = t;
+    }
+    return end;
+}
+
+// Where the JPEG at h has its compressed image data: walk the marker segments
+// (APPn, DQT, DHT, SOFn, ..., each FF xx plus a 2-byte big-endian length that
+// counts itself) up to the first SOS (FF DA) and skip its header. An FF D9
+// before that isn't the end of this file: an EXIF thumbnail is a whole JPEG
+// inside APP1, with its own FF D9. Inside the image data FF is escaped as
+// FF 00, so the first real FF D9 after this is the end.
+// Returns 0 if the segments don't chain up within limit (not a JPEG).
+static uint64_t jpeg_data_start(const unsigned char *map, uint64_t limit, uint64_t h) {
+    uint64_t p = h + 2;
+    while (p + 2 <= limit) {
+        if (map[p] != 0xFF) return 0;
+        unsigned char m = map[p + 1];
+        if (m == 0xFF) { p++; continue; }           // fill byte before a marker
+        if (m == 0xD9) return p;                    // tables only, no image
+        // SOI, RSTn, TEM and 00 have no length and don't belong here
+        if (m == 0x00 || m == 0x01 || (m >= 0xD0 && m <= 0xD8)) return 0;
+        if (p + 4 > limit) return 0;
+        uint64_t seg = rd(map + p + 2, 2, 1);
+        if (seg < 2) return 0;
+        p += 2 + seg;
+        if (m == 0xDA) return p <= limit ? p : 0;
+    }
+    return 0;
+}
+
+static int jpeg_header_ok(const unsigned char *map, uint64_t len, uint64_t h) {
+    // FF D8 FF then a plausible first marker: APPn (E0-EF), DQT, SOF0, DHT, COM
+    if (h + 3 >= len) return 0;
+    unsigned char m = map[h + 3];
+    if ((m & 0xF0) != 0xE0 && m != 0xDB && m != 0xC0 && m != 0xC4 && m != 0xFE) return 0;
+    return jpeg_data_start(map, len, h) != 0;
+}
+
+// End (exclusive) of the file whose header is headers->v[hi], or 0
+static uint64_t find_end(enum ftype t, const struct offsets *headers, size_t hi,
+                         const struct offsets *footers, const unsigned char *map, uint64_t len) {
+    uint64_t h = headers->v[hi];
+    uint64_t limit = h + types[t].max_size < len ? h + types[t].max_size : len;
+    size_t f;
+
+    switch (t) {
+    case T_JPEG: {
+        uint64_t data = jpeg_data_start(map, limit, h);
+        if (data == 0) return 0;
+        f = lower_bound(footers, data);
+        if (f < footers->n && footers->v[f] + 2 <= limit) return footers->v[f] + 2;
+        return 0;
+    }
+    case T_PNG:
+        f = lower_bound(footers, h + 8);
+        if (f < footers->n && footers->v[f] + 8 <= limit) return footers->v[f] + 8;
+        return 0;
+    case T_ZIP: {
+        f = lower_bound(footers, h + 4);
+        if (f == footers->n || footers->v[f] + 22 > len) return 0;
+        uint64_t e = footers->v[f];
+        uint64_t end = e + 22 + rd(map + e + 20, 2, 0);   // + comment length
+        if (end > len) end = len;
+        return end <= limit ? end : 0;
+    }
+    case T_PDF: {
+        uint64_t next = hi + 1 < headers->n ? headers->v[hi + 1] : len;
+        if (next < limit) limit = next;
+        f = lower_bound(footers, limit);    // first %%EOF at or past the limit
+        while (f > 0 && footers->v[f - 1] + 5 > limit) f--;
+        if (f == 0 || footers->v[f - 1] < h + 5) return 0;
+        uint64_t end = footers->v[f - 1] + 5;
+        // the line ending after %%EOF belongs to the file
+        if (end < len && map[end] == '\r') end++;
+        if (end < len && map[end] == '\n') end++;
+        return end;
+    }
+    case T_ELF: {
+        uint64_t size = elf_size(map + h, len - h);
+        if (size == 0 || h + size > limit) return 0;
+        return h + size;
+    }
+    default:
+        return 0;
+    }
+}
+
+static int item_cmp(const void *a, const void *b) {
+    const struct item *x = a, *y = b;
+    if (x->start != y->start) return x->start < y->start ? -1 : 1;
+    return (int)x->type - (int)y->type;
+}
+
+// --- extraction ---
+
+static int extract(int in_fd, const unsigned char *map, const struct item *it,
+                   const char *dir, char *name, size_t name_len) {
+    snprintf(name, name_len, "%s/%016llx.%s", dir, (unsigned long long)it->start, types[it->type].ext);
+    int out = open(name, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (out < 0) return -1;
+
+    loff_t off = (loff_t)it->start;
+    uint64_t left = it->end - it->start;
+    while (left > 0) {
+        ssize_t n = copy_file_range(in_fd, &off, out, NULL, (size_t)left, 0);
+        if (n > 0) {
+            left -= (uint64_t)n;
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EXDEV || errno == ENOSYS || errno == EINVAL ||
+                      errno == EOPNOTSUPP || errno == EBADF)) {
+            // no in-kernel copy between these two (old kernel, odd fs):
+            // write straight from the mapping instead
+            if (write_all(out, map + off, (size_t)left) != 0) break;
+            left = 0;
+            break;
+        }
+        break;                  // real error, or an unexpected 0
+    }
+    int saved = errno;
+    if (close(out) != 0 && left == 0) return -1;
+    errno = saved;
+    return left == 0 ? 0 : -1;
+}
+
+static void carve_usage(const char *prog) {
+    fprintf(stderr, "Usage: %s IMAGE [-o DIR] [-j N]\n", prog);
+    fprintf(stderr, "  Finds embedded JPEG, PNG, ZIP, PDF and ELF files.\n");
+    fprintf(stderr, "  -o DIR   copy each complete file to DIR/<offset>.<ext>\n");
+    fprintf(stderr, "  -j N     scanning threads (default: one per CPU, max %d)\n", MAX_THREADS);
+}
+
+int cmd_carve(int argc, char **argv) {
+    const char *path = NULL, *dir = NULL;
+    long jobs = sysconf(_SC_NPROCESSORS_ONLN);
+
+    for (int i = 1; i < argc; i++) {
+        const char *a = argv[i];
+        if (strcmp(a, "-o") == 0) {
+            if (i + 1 >= argc) { fprintf(stderr, "-o needs a directory\n"); return 1; }
+            dir = argv[++i];
+        } else if (strcmp(a, "-j") == 0) {
+            size_t j;
+            if (i + 1 >= argc || parse_size(argv[i + 1], &j) != 0 || j == 0 || j > MAX_THREADS) {
+                fprintf(stderr, "-j needs a thread count from 1 to %d\n", MAX_THREADS);
+                return 1;
+            }
+            jobs = (long)j;
+            i++;
+        } else if (strcmp(a, "-h") == 0 || strcmp(a, "--help") == 0) {
+            carve_usage(argv[0]);
+            return 0;
+        } else if (a[0] == '-' && a[1] != '\0') {
+            fprintf(stderr, "Unknown option: %s\n", a);
+            carve_usage(argv[0]);
+            return 1;
+        } else if (!path) {
+            path = a;
+        } else {
+            fprintf(stderr, "Only one image, please\n");
+            return 1;
+        }
+    }
+    if (!path) { carve_usage(argv[0]); return 1; }
+    if (jobs < 1) jobs = 1;
+    if (jobs > MAX_THREADS) jobs = MAX_THREADS;
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) { perror("open"); return 1; }
+    size_t len = 0;
+    const unsigned char *map = map_input(fd, &len);
+    if (!map) {
+        // an empty file has nothing to carve; anything else we can't map
+        struct stat st;
+        int empty = fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size == 0;
+        if (!empty) fprintf(stderr, "%s: need a regular, mappable image file\n", path);
+        close(fd);
+        return empty ? 0 : 1;
+    }
+    if (dir && mkdir(dir, 0755) != 0 && errno != EEXIST) {
+        perror("mkdir");
+        munmap((void *)map, len);
+        close(fd);
+        return 1;
+    }
+
+    // 1. one automaton for every header and footer
+    const char *patterns[2 * NTYPES];
+    size_t npat = 0;
+    for (int t = 0; t < NTYPES; t++) {
+        patterns[npat++] = types[t].header;
+        // ELF has no footer. Its slot repeats the header, and a repeated
+        // pattern is only ever reported under its first index.
+        patterns[npat++] = types[t].footer ? types[t].footer : types[t].header;
+    }
+    struct sig_ac *ac = sig_ac_build(patterns, npat);
+    if (!ac) {
+        perror("sig_ac_build");
+        munmap((void *)map, len);
+        close(fd);
+        return 1;
+    }
+
+    // 2. scan the chunks in parallel
+    struct scan_pool p = { .map = map, .len = len, .ac = ac, .overlap = sig_ac_maxlen(ac) - 1 };
+    p.nchunks = (len + CHUNK - 1) / CHUNK;
+    p.chunks = calloc(p.nchunks, sizeof *p.chunks);
+    struct offsets offs[2 * NTYPES] = { 0 };
+    struct item *items = NULL;
+    int rc = 0;
+    if (!p.chunks) {
+        perror("calloc");
+        rc = 1;
+        goto done;
+    }
+    for (size_t i = 0; i < p.nchunks; i++) {
+        p.chunks[i].start = (uint64_t)i * CHUNK;
+        p.chunks[i].end = (uint64_t)i * CHUNK + CHUNK < len ? (uint64_t)i * CHUNK + CHUNK : len;
+    }
+    pthread_mutex_init(&p.mu, NULL);
+    if ((size_t)jobs > p.nchunks) jobs = (long)p.nchunks;
+    pthread_t tids[MAX_THREADS];
+    int started = 0;
+    for (; started < jobs; started++) {
+        if (pthread_create(&tids[started], NULL, scan_worker, &p) != 0) break;
+    }
+    if (started == 0) scan_worker(&p);
+    for (int t = 0; t < started; t++) pthread_join(tids[t], NULL);
+    pthread_mutex_destroy(&p.mu);
+
+    // 3. gather offsets per pattern, in image order (chunks are in order,
+    //    and one pattern's hits within a chunk are too)
+    size_t counts[2 * NTYPES] = { 0 };
+    for (size_t i = 0; i < p.nchunks; i++) {
+        if (p.chunks[i].failed) { fprintf(stderr, "out of memory while scanning\n"); rc = 1; goto done; }
+        for (size_t k = 0; k < p.chunks[i].hits.n; k++) counts[p.chunks[i].hits.v[k].pat]++;
+    }
+    for (size_t k = 0; k < npat; k++) {
+        offs[k].v = malloc((counts[k] ? counts[k] : 1) * sizeof *offs[k].v);
+        if (!offs[k].v) { perror("malloc"); rc = 1; goto done; }
+    }
+    for (size_t i = 0; i < p.nchunks; i++) {
+        for (size_t k = 0; k < p.chunks[i].hits.n; k++) {
+            const struct hit *h = &p.chunks[i].hits.v[k];
+            offs[h->pat].v[offs[h->pat].n++] = h->off;
+        }
+    }
+
+    // 4. pair each header with its end. A header inside the previous file of
+    //    the same type (the next entry of a ZIP, an EXIF thumbnail) is part
+    //    of that file, not a new one.
+    size_t nitems = 0, cap = 0;
+    for (int t = 0; t < NTYPES; t++) {
+        const struct offsets *hs = &offs[PAT_HEADER(t)];
+        uint64_t covered = 0;
+        for (size_t i = 0; i < hs->n; i++) {
+            uint64_t h = hs->v[i];
+            if (h < covered) continue;
+            if (t == T_JPEG && !jpeg_header_ok(map, len, h)) continue;
+            uint64_t end = find_end((enum ftype)t, hs, i, &offs[PAT_FOOTER(t)], map, len);
+            if (t == T_ELF && end == 0) continue;   // magic without a sane header
+            if (nitems == cap) {
+                cap = cap ? cap * 2 : 64;
+                struct item *bigger = realloc(items, cap * sizeof *bigger);
+                if (!bigger) { perror("realloc"); rc = 1; goto done; }
+                items = bigger;
+            }
+            items[nitems++] = (struct item){ h, end, (enum ftype)t };
+            if (end) covered = end;
+        }
+    }
+    qsort(items, nitems, sizeof *items, item_cmp);
+
+    // 5. report (and copy out)
+    if (dir) printf("%-16s  %12s  %-4s  %s\n", "offset", "size", "type", "file");
+    else printf("%-16s  %12s  %s\n", "offset", "size", "type");
+    size_t found = 0, written = 0;
+    char name[4096];
+    for (size_t i = 0; i < nitems; i++) {
+        const struct item *it = &items[i];
+        if (!it->end) {
+            printf("%016llx  %12s  %-4s  (no end found within %llu MiB)\n",
+                   (unsigned long long)it->start, "-", types[it->type].ext,
+                   (unsigned long long)(types[it->type].max_size >> 20));
+            continue;
+        }
+        found++;
+        printf("%016llx  %12llu  %s", (unsigned long long)it->start,
+               (unsigned long long)(it->end - it->start), types[it->type].ext);
+        if (dir) {
+            printf("%*s", 4 - (int)strlen(types[it->type].ext), "");
+            if (extract(fd, map, it, dir, name, sizeof name) == 0) {
+                printf("  %s", name);
+                written++;
+            } else {
+                printf("  (%s: %s)", name, strerror(errno));
+                rc = 1;
+            }
+        }
+        putchar('\n');
+    }
+    printf("%zu complete file%s", found, found == 1 ? "" : "s");
+    if (dir) printf(", %zu written to %s", written, dir);
+    printf(", %zu header%s without an end\n", nitems - found, nitems - found == 1 ? "" : "s");
+
+done:
+    free(items);
+    for (size_t k = 0; k < 2 * NTYPES; k++) free(offs[k].v);
+    for (size_t i = 0; p.chunks && i < p.nchunks; i++) free(p.chunks[i].hits.v);
+    free(p.chunks);
+    sig_ac_free(ac);
+    munmap((void *)map, len);
+    close(fd);
+    if (fflush(stdout) != 0) { perror("write"); rc = 1; }
+    return rc;
+}
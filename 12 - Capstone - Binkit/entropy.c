@@ -0,0 +1,277 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include "binkit.h"
+#include "util.h"
+
+// binkit entropy: where in a blob is the data compressed or encrypted?
+//
+// Shannon entropy in bits per byte: ~8 for random/compressed/encrypted data,
+// ~4-5 for text, lower for code and tables, 0 for padding. We print one row
+// per --block with the block's own entropy plus the lowest and highest
+// entropy of any --window sliding through it (a short packed region inside a
+// mostly-plain block shows up in "max").
+//
+// How it stays fast:
+//   * Counting uses 4 histograms, byte k going to histogram k % 4. With one
+//     histogram, a run of the same byte makes every increment wait on the
+//     store before it; four independent ones keep the CPU busy.
+//   * Every byte is counted exactly once, into running totals that never
+//     reset. Once per --step we merge the totals and keep a snapshot; window
+//     counts are "totals now - snapshot from one window ago" (uint32 wraps,
+//     but the difference is at most the window, so it comes out right).
+//   * Entropy is H = log2(n) - (sum of c*log2(c)) / n, with c*log2(c) from
+//     a table for c = 0..window. Each step updates the sum by the difference
+//     for all 256 byte values, so a step costs the same ~256 operations
+//     however many bytes it moved. That's why --step has a floor of 256:
+//     the window bookkeeping then costs at most about one operation per
+//     byte on top of counting.
+
+enum {
+    MAX_WINDOW = 1 << 20,
+    MAX_SLOTS = 1024,           // window / step
+    MAX_BLOCK = 1 << 30,        // keeps per-block counts inside uint32
+    SUBHIST = 4,
+    MIN_STEP = 256,             // one step's bookkeeping is O(256), see above
+};
+
+struct entropy_opts {
+    size_t window;      // sliding window size
+    size_t step;        // window moves this much between samples
+    size_t block;       // one output row per block
+};
+
+struct snapshot {
+    uint32_t tot[256];          // merged running totals after some step
+    uint64_t seen;
+};
+
+struct slide {
+    uint32_t sub[SUBHIST][256]; // running totals, split 4 ways
+    struct snapshot *snap;      // the last window/step snapshots, oldest at `next`
+    size_t slots, next;
+    uint32_t count[256];        // window counts at the last step
+    uint64_t n;                 // bytes in the window (less than window only near the ends)
+    double sum;                 // sum of clog2c[count[b]]
+    uint64_t seen;              // bytes fed so far
+};
+
+static double *clog2c;          // clog2c[c] = c * log2(c), c = 0..window
+
+static void count_bytes(uint32_t h[SUBHIST][256], const unsigned char *p, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        h[0][p[i]]++;
+        h[1][p[i + 1]]++;
+        h[2][p[i + 2]]++;
+        h[3][p[i + 3]]++;
+        h[0][p[i + 4]]++;
+        h[1][p[i + 5]]++;
+        h[2][p[i + 6]]++;
+        h[3][p[i + 7]]++;
+    }
+    for (; i < n; i++) h[i % SUBHIST][p[i]]++;
+}
+
+static void merge_totals(const struct slide *s, uint32_t out[256]) {
+    for (int b = 0; b < 256; b++) {
+        out[b] = s->sub[0][b] + s->sub[1][b] + s->sub[2][b] + s->sub[3][b];
+    }
+}
+
+// Called after each step: take the new window counts, patch sum, and leave
+// the totals in the snapshot slot for when this step leaves the window. The
+// window is the last `slots` steps; only the very last step of the input can
+// be short, which makes that final window a bit smaller.
+//
+// The integer half is a plain loop over 256 lanes the compiler vectorizes.
+// The table half has no "did this count change?" branch: on mixed data it's
+// a coin flip and the mispredicts cost more than adding 0. Four partial sums
+// so the adds don't all queue behind each other.
+static void slide_step(struct slide *s, size_t window) {
+    struct snapshot *old = &s->snap[s->next];
+    uint32_t tot[256], now[256];
+    merge_totals(s, tot);
+    if (s->seen > window) {
+        for (int b = 0; b < 256; b++) now[b] = tot[b] - old->tot[b];
+        s->n = s->seen - old->seen;
+    } else {
+        memcpy(now, tot, sizeof now);
+        s->n = s->seen;
+    }
+    memcpy(old->tot, tot, sizeof tot);
+    old->seen = s->seen;
+    s->next = s->next + 1 == s->slots ? 0 : s->next + 1;
+
+    double part[4] = { 0, 0, 0, 0 };
+    for (int b = 0; b < 256; b += 4) {
+        for (int k = 0; k < 4; k++) {
+            part[k] += clog2c[now[b + k]] - clog2c[s->count[b + k]];
+        }
+    }
+    memcpy(s->count, now, sizeof now);
+    s->sum += (part[0] + part[1]) + (part[2] + part[3]);
+}
+
+// Add the sum up from scratch, so rounding in the patched sum can't pile up
+// over a multi-GB file. Once per block is plenty.
+static void slide_resum(struct slide *s) {
+    s->sum = 0;
+    for (int b = 0; b < 256; b++) s->sum += clog2c[s->count[b]];
+}
+
+static double window_entropy(const struct slide *s) {
+    if (s->n == 0) return 0;
+    double h = log2((double)s->n) - s->sum / (double)s->n;
+    return h < 0 ? 0 : h; // -0.0000 from rounding on constant data
+}
+
+static double hist_entropy(const uint64_t h[256], uint64_t n) {
+    if (n == 0) return 0;
+    double e = 0;
+    for (int b = 0; b < 256; b++) {
+        if (h[b]) {
+            double p = (double)h[b] / (double)n;
+            e -= p * log2(p);
+        }
+    }
+    return e;
+}
+
+static void print_row(const char *label, double block, double lo, double hi) {
+    char bar[33];
+    int len = (int)(block * 4 + 0.5); // 32 chars = 8 bits/byte
+    if (len > 32) len = 32;
+    memset(bar, '#', (size_t)len);
+    bar[len] = '\0';
+    printf("%-12s %6.4f  %6.4f  %6.4f  %s\n", label, block, lo, hi, bar);
+}
+
+static void entropy_usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [file] [--window N] [--step N] [--block N]\n", prog);
+    fprintf(stderr, "  --window N   sliding window size (default 16K, max 1M)\n");
+    fprintf(stderr, "  --step N     window moves N bytes between samples (default window/4, min %d)\n", MIN_STEP);
+    fprintf(stderr, "  --block N    bytes per output row (default 64K)\n");
+    fprintf(stderr, "  Sizes accept K/M/G. window and block must be multiples of step.\n");
+}
+
+int cmd_entropy(int argc, char **argv) {
+    const char *path = NULL;
+    struct entropy_opts o = { .window = 16384, .step = 0, .block = 65536 };
+
+    for (int i = 1; i < argc; i++) {
+        const char *a = argv[i];
+        size_t *dst = NULL;
+        if (strcmp(a, "--window") == 0) dst = &o.window;
+        else if (strcmp(a, "--step") == 0) dst = &o.step;
+        else if (strcmp(a, "--block") == 0) dst = &o.block;
+        if (dst) {
+            if (i + 1 >= argc || parse_size(argv[i + 1], dst) != 0 || *dst == 0) {
+                fprintf(stderr, "%s needs a size above 0\n", a);
+                return 1;
+            }
+            i++;
+        } else if (strcmp(a, "-h") == 0 || strcmp(a, "--help") == 0) {
+            entropy_usage(argv[0]);
+            return 0;
+        } else if (a[0] == '-' && a[1] != '\0') {
+            fprintf(stderr, "Unknown option: %s\n", a);
+            entropy_usage(argv[0]);
+            return 1;
+        } else if (!path) {
+            path = a;
+        } else {
+            fprintf(stderr, "Only one file, please\n");
+            return 1;
+        }
+    }
+    if (o.step == 0) o.step = o.window / 4 > MIN_STEP ? o.window / 4 : MIN_STEP;
+    if (o.step < MIN_STEP || o.window > MAX_WINDOW || o.window % o.step != 0 ||
+        o.window / o.step > MAX_SLOTS || o.block > MAX_BLOCK || o.block % o.step != 0) {
+        fprintf(stderr, "window must be <= 1M and block <= 1G, both multiples of step,\n"
+                        "and step at least %d and at least window/%d\n", MIN_STEP, MAX_SLOTS);
+        return 1;
+    }
+
+    int fd = open_input(path);
+    if (fd < 0) { perror("open"); return 1; }
+
+    unsigned char *buf = malloc(o.block);
+    struct slide *s = calloc(1, sizeof *s);
+    struct snapshot *snap = calloc(o.window / o.step, sizeof *snap);
+    clog2c = malloc((o.window + 1) * sizeof *clog2c);
+    if (!buf || !s || !snap || !clog2c) {
+        perror("malloc");
+        free(buf);
+        free(s);
+        free(snap);
+        free(clog2c);
+        if (fd != STDIN_FILENO) close(fd);
+        return 1;
+    }
+    s->snap = snap;
+    s->slots = o.window / o.step;
+    clog2c[0] = 0;
+    for (size_t c = 1; c <= o.window; c++) clog2c[c] = (double)c * log2((double)c);
+
+    printf("window %zu, step %zu, block %zu (bits per byte; 8 = random)\n",
+           o.window, o.step, o.block);
+    printf("%-12s %6s  %6s  %6s\n", "offset", "block", "min", "max");
+
+    uint64_t total[256] = { 0 };
+    uint64_t offset = 0;
+    int rc = 0;
+    uint32_t start[256] = { 0 };    // running totals when this block began
+    for (;;) {
+        ssize_t got = read_full(fd, buf, o.block);
+        if (got < 0) { perror("read"); rc = 1; break; }
+        if (got == 0) break;
+
+        double lo = 8, hi = 0;
+        for (size_t i = 0; i < (size_t)got; i += o.step) {
+            size_t n = (size_t)got - i < o.step ? (size_t)got - i : o.step;
+            count_bytes(s->sub, buf + i, n);
+            s->seen += n;
+            slide_step(s, o.window);
+
+            double h = window_entropy(s);
+            if (h < lo) lo = h;
+            if (h > hi) hi = h;
+        }
+
+        // the block's own histogram falls out of the running totals too
+        uint32_t end[256];
+        uint64_t bh[256];
+        merge_totals(s, end);
+        for (int b = 0; b < 256; b++) {
+            bh[b] = end[b] - start[b];
+            total[b] += bh[b];
+        }
+        memcpy(start, end, sizeof start);
+        slide_resum(s);
+
+        char label[24];
+        snprintf(label, sizeof label, "%08llx", (unsigned long long)offset);
+        print_row(label, hist_entropy(bh, (uint64_t)got), lo, hi);
+
+        offset += (uint64_t)got;
+        if ((size_t)got < o.block) break;
+    }
+
+    if (rc == 0 && offset > 0) {
+        printf("total: %llu bytes, %6.4f bits/byte\n",
+               (unsigned long long)offset, hist_entropy(total, offset));
+    }
+
+    free(buf);
+    free(s);
+    free(snap);
+    free(clog2c);
+    clog2c = NULL;
+    if (fd != STDIN_FILENO) close(fd);
+    return rc;
+}
@@ -1,45 +1,288 @@
+#define _POSIX_C_SOURCE 200809L
 #include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "binkit.h"
+#include "util.h"
 
-int cmd_hexdump(int argc, char **argv) {
-    FILE *fp = stdin;                // default: read from standard input
-    unsigned long offset = 0;        // how many bytes we’ve printed so far
-    unsigned char byte;              // one byte buffer
- 
-    // If a filename is provided (and not an option), open it.
-    if (argc > 1 && argv[1][0] != '-') {
-        fp = fopen(argv[1], "rb");
-        if (!fp) { perror("fopen"); return 1; }
-    } else if (argc < 1) {
-        fprintf(stderr, "Usage: %s [file]\n", argv[0]);
-        return 1;
+// v0 read one byte with fread and called printf for it, which is fine for
+// "hello\n" and painful for a 100 MB binary. Now we read a big block at a
+// time, build all of its rows in one output buffer with table lookups, and
+// hand that to write() once.
+//
+// Layouts:
+//   default       00000000: 68 65 6C 6C 6F 0A           (same bytes as v0)
+//   --canonical   00000000  68 65 6c 6c 6f 0a  ...  |hello.|   (hexdump -C)
+//   --width N     N bytes per row (default 16)
+//   --group N     print N bytes together before a space (default 1)
+
+enum {
+    MAX_WIDTH = 256,
+    BLOCK_ROWS = 4096,      // rows per read; block = BLOCK_ROWS * width bytes
+};
+
+struct layout {
+    size_t width;           // bytes per row
+    size_t group;           // bytes per space-separated group
+    int canonical;          // hexdump -C look: lowercase, ASCII column, '*' squeeze
+};
+
+// "XX" for every byte value, upper and lower case, plus the ASCII gutter char
+static char hex_upper[256][2];
+static char hex_lower[256][2];
+static char gutter[256];
+
+static void init_tables(void) {
+    static const char up[] = "0123456789ABCDEF";
+    static const char lo[] = "0123456789abcdef";
+    for (int b = 0; b < 256; b++) {
+        hex_upper[b][0] = up[b >> 4];
+        hex_upper[b][1] = up[b & 0xF];
+        hex_lower[b][0] = lo[b >> 4];
+        hex_lower[b][1] = lo[b & 0xF];
+        gutter[b] = (b >= 0x20 && b < 0x7F) ? (char)b : '.';
+    }
+}
+
+// Offset label: at least 8 hex digits, more once the file passes 4 GiB
+// (same as printf("%08lX")).
+static char *put_offset(char *p, uint64_t off, int lower) {
+    const char *digits = lower ? "0123456789abcdef" : "0123456789ABCDEF";
+    int n = 8;
+    while (n < 16 && (off >> (4 * n)) != 0) n++;
+    for (int i = n - 1; i >= 0; i--) {
+        *p++ = digits[(off >> (4 * i)) & 0xF];
+    }
+    return p;
+}
+
+// One row of `n` bytes. Every caller passes width/group/canonical as
+// constants, so after inlining the compiler builds a separate loop for each
+// layout with the group breaks and the canonical extras resolved at compile
+// time, instead of testing the layout for every byte.
+static inline __attribute__((always_inline))
+char *put_row(char *p, uint64_t off, const unsigned char *b, size_t n,
+              size_t width, size_t group, int canonical) {
+    p = put_offset(p, off, canonical);
+    if (canonical) {
+        *p++ = ' ';
+        *p++ = ' ';
+    } else {
+        *p++ = ':';
+        *p++ = ' ';
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        memcpy(p, canonical ? hex_lower[b[i]] : hex_upper[b[i]], 2);
+        p += 2;
+        if (group == 1 || (i + 1) % group == 0 || i + 1 == n) *p++ = ' ';
+        // hexdump -C's extra space down the middle of the row
+        if (canonical && i + 1 == width / 2 && (width / 2) % group == 0) *p++ = ' ';
     }
 
-    // Read 1 byte at a time and print it in hex, 16 per line.
-    while (fread(&byte, 1, 1, fp) == 1) {
-        if (offset % 16 == 0) {
-            // Print the starting offset for this row (8 hex digits)
-            printf("%08lX: ", offset);
+    if (canonical) {
+        // pad a short last row so the ASCII column lines up; the group the
+        // last byte fell in was already closed by the `i + 1 == n` space
+        for (size_t i = n; i < width; i++) {
+            *p++ = ' ';
+            *p++ = ' ';
+            if (group == 1 || (((i + 1) % group == 0 || i + 1 == width) && i / group != (n - 1) / group)) *p++ = ' ';
+            if (i + 1 == width / 2 && (width / 2) % group == 0) *p++ = ' ';
         }
+        *p++ = ' ';
+        *p++ = '|';
+        for (size_t i = 0; i < n; i++) *p++ = gutter[b[i]];
+        *p++ = '|';
+    }
+    *p++ = '\n';
+    return p;
+}
 
-        // Print the current byte as two hex digits
-        printf("%02X ", byte);
+// Squeeze state for --canonical (a run of identical rows prints as "*")
+struct squeeze {
+    int have_prev;
+    int squeezing;
+    unsigned char prev[MAX_WIDTH];
+};
 
-        // Move to the next byte; if we've printed 16, end the line.
-        offset++;
-        if (offset % 16 == 0) {
-            putchar('\n');
+// Format `len` bytes (whole rows except maybe the very last) into dst.
+// Instantiated once per common layout by DEFINE_FORMATTER below.
+static inline __attribute__((always_inline))
+size_t format_rows(char *dst, uint64_t off, const unsigned char *buf, size_t len,
+                   struct squeeze *sq, size_t width, size_t group, int canonical) {
+    char *p = dst;
+    for (size_t i = 0; i < len; i += width) {
+        size_t n = len - i < width ? len - i : width;
+        if (canonical) {
+            if (n == width && sq->have_prev && memcmp(buf + i, sq->prev, width) == 0) {
+                if (!sq->squeezing) {
+                    *p++ = '*';
+                    *p++ = '\n';
+                    sq->squeezing = 1;
+                }
+                continue;
+            }
+            sq->squeezing = 0;
+            if (n == width) {
+                memcpy(sq->prev, buf + i, width);
+                sq->have_prev = 1;
+            }
         }
+        p = put_row(p, off + i, buf + i, n, width, group, canonical);
+    }
+    return (size_t)(p - dst);
+}
+
+typedef size_t (*formatter_fn)(char *dst, uint64_t off, const unsigned char *buf, size_t len,
+                               struct squeeze *sq, const struct layout *lay);
+
+#define DEFINE_FORMATTER(name, W, G, C)                                            \
+    static size_t name(char *dst, uint64_t off, const unsigned char *buf, size_t len, \
+                       struct squeeze *sq, const struct layout *lay) {              \
+        (void)lay;                                                                 \
+        return format_rows(dst, off, buf, len, sq, W, G, C);                       \
+    }
+
+DEFINE_FORMATTER(fmt_16_1, 16, 1, 0)    // the v0 layout
+DEFINE_FORMATTER(fmt_16_2, 16, 2, 0)
+DEFINE_FORMATTER(fmt_16_4, 16, 4, 0)
+DEFINE_FORMATTER(fmt_16_8, 16, 8, 0)
+DEFINE_FORMATTER(fmt_32_1, 32, 1, 0)
+DEFINE_FORMATTER(fmt_32_4, 32, 4, 0)
+DEFINE_FORMATTER(fmt_8_1, 8, 1, 0)
+DEFINE_FORMATTER(fmt_c16_1, 16, 1, 1)   // --canonical
+DEFINE_FORMATTER(fmt_c32_1, 32, 1, 1)
+
+// Anything else: same code, layout read at runtime
+static size_t fmt_generic(char *dst, uint64_t off, const unsigned char *buf, size_t len,
+                          struct squeeze *sq, const struct layout *lay) {
+    if (lay->canonical) {
+        return format_rows(dst, off, buf, len, sq, lay->width, lay->group, 1);
     }
+    return format_rows(dst, off, buf, len, sq, lay->width, lay->group, 0);
+}
+
+static const struct {
+    size_t width, group;
+    int canonical;
+    formatter_fn fn;
+} formatters[] = {
+    { 16, 1, 0, fmt_16_1 },
+    { 16, 2, 0, fmt_16_2 },
+    { 16, 4, 0, fmt_16_4 },
+    { 16, 8, 0, fmt_16_8 },
+    { 32, 1, 0, fmt_32_1 },
+    { 32, 4, 0, fmt_32_4 },
+    { 8, 1, 0, fmt_8_1 },
+    { 16, 1, 1, fmt_c16_1 },
+    { 32, 1, 1, fmt_c32_1 },
+};
 
-    // If we ended mid-row, print a final newline
-    if (offset % 16 != 0) {
-        putchar('\n');
+static formatter_fn pick_formatter(const struct layout *lay) {
+    for (size_t i = 0; i < sizeof formatters / sizeof formatters[0]; i++) {
+        if (formatters[i].width == lay->width && formatters[i].group == lay->group &&
+            formatters[i].canonical == lay->canonical) {
+            return formatters[i].fn;
+        }
     }
+    return fmt_generic;
+}
 
-    if (fp != stdin) fclose(fp);
-    return 0;
+// Longest possible row for a layout, so we can size the output buffer
+static size_t max_row_chars(const struct layout *lay) {
+    return 16 + 2                       // offset + ": "
+         + lay->width * 3 + 1           // "XX " per byte, middle gap
+         + 2 + lay->width + 1 + 1;      // " |", gutter, "|", '\n'
 }
 
-int main(int argc, char **argv) {
-    return cmd_hexdump(argc, argv);
-}
\ No newline at end of file
+static void hexdump_usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [file] [--canonical] [--width N] [--group N]\n", prog);
+    fprintf(stderr, "  file           read this file (stdin if omitted or \"-\")\n");
+    fprintf(stderr, "  -C, --canonical  hexdump -C style: lowercase, ASCII column, '*' for repeats\n");
+    fprintf(stderr, "  -w, --width N  bytes per row (1-%d, default 16)\n", MAX_WIDTH);
+    fprintf(stderr, "  -g, --group N  bytes printed together between spaces (default 1)\n");
+}
+
+int cmd_hexdump(int argc, char **argv) {
+    const char *path = NULL;
+    struct layout lay = { .width = 16, .group = 1, .canonical = 0 };
+
+    for (int i = 1; i < argc; i++) {
+        const char *a = argv[i];
+        if (strcmp(a, "-C") == 0 || strcmp(a, "--canonical") == 0) {
+            lay.canonical = 1;
+        } else if (strcmp(a, "-w") == 0 || strcmp(a, "--width") == 0 ||
+                   strcmp(a, "-g") == 0 || strcmp(a, "--group") == 0) {
+            int is_width = a[1] == 'w' || a[2] == 'w';
+            size_t v;
+            if (i + 1 >= argc || parse_size(argv[i + 1], &v) != 0 || v == 0 ||
+                (is_width && v > MAX_WIDTH)) {
+                fprintf(stderr, "%s needs a number%s\n", a, is_width ? " from 1 to 256" : " above 0");
+                return 1;
+            }
+            if (is_width) {
+                lay.width = v;
+            } else {
+                lay.group = v;
+            }
+            i++;
+        } else if (strcmp(a, "-h") == 0 || strcmp(a, "--help") == 0) {
+            hexdump_usage(argv[0]);
+            return 0;
+        } else if (a[0] == '-' && a[1] != '\0') {
+            fprintf(stderr, "Unknown option: %s\n", a);
+            hexdump_usage(argv[0]);
+            return 1;
+        } else if (!path) {
+            path = a;
+        } else {
+            fprintf(stderr, "Only one file, please (got '%s' and '%s')\n", path, a);
+            return 1;
+        }
+    }
+    if (lay.group > lay.width) lay.group = lay.width;
+
+    int fd = open_input(path);      // default: read from standard input
+    if (fd < 0) { perror("open"); return 1; }
+
+    init_tables();
+    formatter_fn format = pick_formatter(&lay);
+    size_t block = BLOCK_ROWS * lay.width;
+    unsigned char *in = malloc(block);
+    char *out = malloc(BLOCK_ROWS * max_row_chars(&lay) + 32);
+    if (!in || !out) {
+        perror("malloc");
+        free(in);
+        free(out);
+        if (fd != STDIN_FILENO) close(fd);
+        return 1;
+    }
+
+    struct squeeze sq = { 0 };
+    uint64_t offset = 0;
+    int rc = 0;
+    for (;;) {
+        ssize_t got = read_full(fd, in, block);
+        if (got < 0) { perror("read"); rc = 1; break; }
+        if (got == 0) break;
+
+        size_t n = format(out, offset, in, (size_t)got, &sq, &lay);
+        if (write_all(STDOUT_FILENO, out, n) != 0) { perror("write"); rc = 1; break; }
+        offset += (uint64_t)got;
+        if ((size_t)got < block) break; // short block = end of input
+    }
+
+    // hexdump -C always finishes with the total length on its own line
+    if (rc == 0 && lay.canonical && offset > 0) {
+        char *p = put_offset(out, offset, 1);
+        *p++ = '\n';
+        if (write_all(STDOUT_FILENO, out, (size_t)(p - out)) != 0) { perror("write"); rc = 1; }
+    }
+
+    free(in);
+    free(out);
+    if (fd != STDIN_FILENO) close(fd);
+    return rc;
+}
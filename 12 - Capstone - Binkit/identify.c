@@ -0,0 +1,321 @@
+#define _XOPEN_SOURCE 700
+#include <errno.h>
+#include <fcntl.h>
+#include <ftw.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "binkit.h"
+#include "sigs.h"
+#include "util.h"
+
+// binkit identify: what is every file under these directories?
+//
+// Like file(1) but only from leading-byte signatures (see sigs.c), and built
+// for trees with hundreds of thousands of files:
+//   * each file costs one open, one pread of the first 512 bytes, one close;
+//   * the signatures are one trie, so the header is walked once;
+//   * nftw() lists the tree on its own thread while worker threads do the
+//     opening and reading, which is where the time goes (syscalls and, on a
+//     cold cache, waiting for the disk).
+// The main thread prints results in walk order as soon as each one and all
+// before it are done, so output streams while the walk is still going, and
+// each path is freed once printed.
+
+enum { MAX_JOBS = 256 };
+
+struct job {
+    char *path;
+    const char *type;           // NULL until a worker is done with it
+    int err;                    // errno when the file couldn't be read
+};
+
+struct pool {
+    pthread_mutex_t mu;
+    pthread_cond_t work;        // new jobs, or the walk finished
+    pthread_cond_t done;        // a job finished
+    struct job *jobs;
+    size_t n, cap, next;
+    int walking;                // nftw still running; done is signalled when it ends
+    int failed;                 // out of memory while listing
+    struct sig_trie *trie;
+};
+
+// nftw() has no user pointer for its callback, so the walk adds jobs here
+static struct pool *walk_pool;
+
+static const char *const T_EMPTY = "empty";
+static const char *const T_TEXT = "ASCII text";
+static const char *const T_DATA = "data";
+static const char *const T_LINK = "symbolic link";
+static const char *const T_SPECIAL = "special file (device, fifo or socket)";
+static const char *const T_UNREADABLE = "unreadable";
+
+static const char *classify_header(const struct sig_trie *trie, const unsigned char *buf, size_t n) {
+    if (n == 0) return T_EMPTY;
+    const struct sig *s = sig_identify(trie, buf, n);
+    if (s) return s->name;
+    for (size_t i = 0; i < n; i++) {
+        unsigned char c = buf[i];
+        if ((c < 0x20 || c > 0x7E) && c != '\t' && c != '\n' && c != '\r' && c != '\f') return T_DATA;
+    }
+    return T_TEXT;
+}
+
+static const char *identify_file(const struct sig_trie *trie, const char *path, int *err) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC | O_NOCTTY);
+    if (fd < 0) {
+        *err = errno;
+        return T_UNREADABLE;
+    }
+    unsigned char buf[SIG_HEADER_MAX];
+    ssize_t got;
+    do {
+        got = pread(fd, buf, sizeof buf, 0);
+    } while (got < 0 && errno == EINTR);
+    int saved = errno;
+    close(fd);
+    if (got < 0) {
+        *err = saved;
+        return T_UNREADABLE;
+    }
+    return classify_header(trie, buf, (size_t)got);
+}
+
+static void *identify_worker(void *arg) {
+    struct pool *p = arg;
+    pthread_mutex_lock(&p->mu);
+    for (;;) {
+        // skip jobs queued with their type already known
+        while (p->next < p->n && p->jobs[p->next].type) p->next++;
+        if (p->next == p->n) {
+            if (!p->walking) break;
+            pthread_cond_wait(&p->work, &p->mu);
+            continue;
+        }
+        size_t i = p->next++;
+        char *path = p->jobs[i].path;   // jobs[] may move while unlocked; the path doesn't
+        pthread_mutex_unlock(&p->mu);
+
+        int err = 0;
+        const char *type = identify_file(p->trie, path, &err);
+
+        pthread_mutex_lock(&p->mu);
+        p->jobs[i].type = type;
+        p->jobs[i].err = err;
+        pthread_cond_broadcast(&p->done);
+    }
+    pthread_mutex_unlock(&p->mu);
+    return NULL;
+}
+
+// Queue a path. Types known without opening the file (links, devices, and
+// anything nftw couldn't stat) are filled in right away.
+static int add_job(struct pool *p, const char *path, const char *type, int err) {
+    char *copy = strdup(path);
+    if (!copy) return -1;
+    pthread_mutex_lock(&p->mu);
+    if (p->n == p->cap) {
+        size_t cap = p->cap ? p->cap * 2 : 4096;
+        struct job *bigger = realloc(p->jobs, cap * sizeof *bigger);
+        if (!bigger) {
+            pthread_mutex_unlock(&p->mu);
+            free(copy);
+            return -1;
+        }
+        p->jobs = bigger;
+        p->cap = cap;
+    }
+    p->jobs[p->n] = (struct job){ .path = copy, .type = type, .err = err };
+    p->n++;
+    if (type) pthread_cond_signal(&p->done);
+    else pthread_cond_signal(&p->work);
+    pthread_mutex_unlock(&p->mu);
+    return 0;
+}
+
+static int visit(const char *path, const struct stat *st, int flag, struct FTW *ftw) {
+    (void)ftw;
+    const char *type = NULL;
+    int err = 0;
+    switch (flag) {
+    case FTW_F:
+        if (!S_ISREG(st->st_mode)) type = T_SPECIAL;  // never open a fifo: it would block
+        break;
+    case FTW_SL:
+    case FTW_SLN:
+        type = T_LINK;
+        break;
+    case FTW_DNR:
+    case FTW_NS:
+        type = T_UNREADABLE;
+        err = errno ? errno : EACCES;   // whatever stat/opendir failed with
+        break;
+    default:
+        return 0;               // directories themselves aren't listed
+    }
+    if (add_job(walk_pool, path, type, err) != 0) {
+        walk_pool->failed = 1;
+        return 1;               // stops the walk
+    }
+    return 0;
+}
+
+struct walk {
+    const char **paths;
+    size_t npaths;
+    int rc;
+};
+
+static void *walk_thread(void *arg) {
+    struct walk *w = arg;
+    struct pool *p = walk_pool;
+    for (size_t i = 0; i < w->npaths && !p->failed; i++) {
+        if (nftw(w->paths[i], visit, 64, FTW_PHYS) == -1) {
+            fprintf(stderr, "%s: %s\n", w->paths[i], strerror(errno));
+            w->rc = 1;
+        }
+    }
+    if (p->failed) { fprintf(stderr, "out of memory listing files\n"); w->rc = 1; }
+
+    pthread_mutex_lock(&p->mu);
+    p->walking = 0;
+    pthread_cond_broadcast(&p->work);
+    pthread_cond_broadcast(&p->done);
+    pthread_mutex_unlock(&p->mu);
+    return NULL;
+}
+
+struct tally {
+    const char *type;
+    size_t count;
+};
+
+static int tally_cmp(const void *a, const void *b) {
+    const struct tally *x = a, *y = b;
+    if (x->count != y->count) return x->count < y->count ? 1 : -1;
+    return strcmp(x->type, y->type);
+}
+
+static void print_summary(const struct job *jobs, size_t n) {
+    // one slot per signature plus the T_* types
+    struct tally *t = calloc(sig_count + 8, sizeof *t);
+    if (!t) { perror("calloc"); return; }
+    size_t nt = 0;
+    for (size_t i = 0; i < n; i++) {
+        size_t k = 0;
+        // types are pointers into sig_table or the T_* strings, so == works
+        while (k < nt && t[k].type != jobs[i].type) k++;
+        if (k == nt) t[nt++] = (struct tally){ jobs[i].type, 0 };
+        t[k].count++;
+    }
+    qsort(t, nt, sizeof t[0], tally_cmp);
+    printf("\n%zu files\n", n);
+    for (size_t k = 0; k < nt; k++) printf("%10zu  %s\n", t[k].count, t[k].type);
+    free(t);
+}
+
+static void identify_usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [path...] [-j N] [--summary]\n", prog);
+    fprintf(stderr, "  path         file or directory to walk (default: .)\n");
+    fprintf(stderr, "  -j N         worker threads (default: 4 per CPU, max %d)\n", MAX_JOBS);
+    fprintf(stderr, "  --summary    finish with a count per type\n");
+}
+
+int cmd_identify(int argc, char **argv) {
+    const char **paths = calloc((size_t)argc, sizeof *paths);
+    size_t npaths = 0;
+    long jobs = sysconf(_SC_NPROCESSORS_ONLN) * 4; // mostly waiting on syscalls/disk
+    int summary = 0;
+    if (!paths) { perror("calloc"); return 1; }
+
+    for (int i = 1; i < argc; i++) {
+        const char *a = argv[i];
+        if (strcmp(a, "-j") == 0) {
+            size_t j;
+            if (i + 1 >= argc || parse_size(argv[i + 1], &j) != 0 || j == 0 || j > MAX_JOBS) {
+                fprintf(stderr, "-j needs a thread count from 1 to %d\n", MAX_JOBS);
+                free(paths);
+                return 1;
+            }
+            jobs = (long)j;
+            i++;
+        } else if (strcmp(a, "--summary") == 0) {
+            summary = 1;
+        } else if (strcmp(a, "-h") == 0 || strcmp(a, "--help") == 0) {
+            identify_usage(argv[0]);
+            free(paths);
+            return 0;
+        } else if (a[0] == '-' && a[1] != '\0') {
+            fprintf(stderr, "Unknown option: %s\n", a);
+            identify_usage(argv[0]);
+            free(paths);
+            return 1;
+        } else {
+            paths[npaths++] = a;
+        }
+    }
+    if (npaths == 0) paths[npaths++] = ".";
+    if (jobs < 1) jobs = 4;
+    if (jobs > MAX_JOBS) jobs = MAX_JOBS;
+
+    struct pool p = { .walking = 1 };
+    p.trie = sig_trie_build();
+    if (!p.trie) { perror("sig_trie_build"); free(paths); return 1; }
+    pthread_mutex_init(&p.mu, NULL);
+    pthread_cond_init(&p.work, NULL);
+    pthread_cond_init(&p.done, NULL);
+
+    pthread_t tids[MAX_JOBS];
+    int started = 0;
+    for (; started < jobs; started++) {
+        if (pthread_create(&tids[started], NULL, identify_worker, &p) != 0) break;
+    }
+
+    struct walk w = { .paths = paths, .npaths = npaths };
+    walk_pool = &p;
+    pthread_t walker;
+    int walker_started = 0;
+    if (started == 0) {
+        // no threads at all: walk, then do the work here
+        walk_thread(&w);
+        identify_worker(&p);
+    } else if (pthread_create(&walker, NULL, walk_thread, &w) == 0) {
+        walker_started = 1;
+    } else {
+        walk_thread(&w);        // the workers still run while we walk
+    }
+
+    // print in walk order as results come in
+    for (size_t i = 0; ; i++) {
+        pthread_mutex_lock(&p.mu);
+        while (i == p.n && p.walking) pthread_cond_wait(&p.done, &p.mu);
+        if (i == p.n) { pthread_mutex_unlock(&p.mu); break; }
+        while (!p.jobs[i].type) pthread_cond_wait(&p.done, &p.mu);
+        struct job j = p.jobs[i];
+        p.jobs[i].path = NULL;  // only the type is needed after this (--summary)
+        pthread_mutex_unlock(&p.mu);
+
+        if (j.err) printf("%s: %s (%s)\n", j.path, j.type, strerror(j.err));
+        else printf("%s: %s\n", j.path, j.type);
+        free(j.path);
+    }
+    if (walker_started) pthread_join(walker, NULL);
+    for (int t = 0; t < started; t++) pthread_join(tids[t], NULL);
+    int rc = w.rc;
+
+    if (summary) print_summary(p.jobs, p.n);
+    if (fflush(stdout) != 0) { perror("write"); rc = 1; }
+
+    free(p.jobs);
+    pthread_cond_destroy(&p.done);
+    pthread_cond_destroy(&p.work);
+    pthread_mutex_destroy(&p.mu);
+    sig_trie_free(p.trie);
+    free(paths);
+    walk_pool = NULL;
+    return rc;
+}
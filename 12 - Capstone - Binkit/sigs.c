@@ -0,0 +1,340 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sigs.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+enum { MAX_PATTERN = 64 };      // bytes in one magic string, "??" included
+
+// Longer patterns beat shorter ones that match too, so "ELF 64-bit" wins
+// over plain "ELF" and the RIFF family is told apart by bytes 8-11.
+const struct sig sig_table[] = {
+    { "PNG image",                    0, "89 50 4E 47 0D 0A 1A 0A" },
+    { "JPEG image",                   0, "FF D8 FF" },
+    { "GIF image (87a)",              0, "47 49 46 38 37 61" },
+    { "GIF image (89a)",              0, "47 49 46 38 39 61" },
+    { "BMP image",                    0, "42 4D ?? ?? ?? ?? 00 00 00 00" },
+    { "TIFF image (little-endian)",   0, "49 49 2A 00" },
+    { "TIFF image (big-endian)",      0, "4D 4D 00 2A" },
+    { "WebP image",                   0, "52 49 46 46 ?? ?? ?? ?? 57 45 42 50" },
+    { "WAV audio",                    0, "52 49 46 46 ?? ?? ?? ?? 57 41 56 45" },
+    { "AVI video",                    0, "52 49 46 46 ?? ?? ?? ?? 41 56 49 20" },
+    { "MP4/QuickTime media",          4, "66 74 79 70" },
+    { "Ogg media",                    0, "4F 67 67 53" },
+    { "FLAC audio",                   0, "66 4C 61 43" },
+    { "MP3 audio (ID3 tag)",          0, "49 44 33" },
+    { "PDF document",                 0, "25 50 44 46 2D" },
+    { "OLE2 compound document (old MS Office)", 0, "D0 CF 11 E0 A1 B1 1A E1" },
+    { "SQLite 3 database",            0, "53 51 4C 69 74 65 20 66 6F 72 6D 61 74 20 33 00" },
+    { "ZIP archive",                  0, "50 4B 03 04" },
+    { "ZIP archive (empty)",          0, "50 4B 05 06" },
+    { "gzip compressed data",         0, "1F 8B 08" },
+    { "bzip2 compressed data",        0, "42 5A 68" },
+    { "xz compressed data",           0, "FD 37 7A 58 5A 00" },
+    { "zstd compressed data",         0, "28 B5 2F FD" },
+    { "7-Zip archive",                0, "37 7A BC AF 27 1C" },
+    { "RAR archive",                  0, "52 61 72 21 1A 07" },
+    { "tar archive",                257, "75 73 74 61 72" },
+    { "ELF",                          0, "7F 45 4C 46" },
+    { "ELF 32-bit",                   0, "7F 45 4C 46 01" },
+    { "ELF 64-bit",                   0, "7F 45 4C 46 02" },
+    { "PE/MS-DOS executable",         0, "4D 5A" },
+    { "Mach-O 32-bit",                0, "CE FA ED FE" },
+    { "Mach-O 64-bit",                0, "CF FA ED FE" },
+    { "Mach-O 32-bit (big-endian)",   0, "FE ED FA CE" },
+    { "Mach-O 64-bit (big-endian)",   0, "FE ED FA CF" },
+    { "Java class / Mach-O universal", 0, "CA FE BA BE" },
+    { "WebAssembly module",           0, "00 61 73 6D" },
+    { "pcap capture",                 0, "D4 C3 B2 A1" },
+    { "pcap capture (big-endian)",    0, "A1 B2 C3 D4" },
+    { "pcapng capture",               0, "0A 0D 0D 0A" },
+    { "script (#!)",                  0, "23 21" },
+};
+const size_t sig_count = sizeof sig_table / sizeof sig_table[0];
+
+// One node per distinct pattern prefix. Children are indexes into nodes[],
+// 0 meaning "none" (the root is never anyone's child). A "??" byte takes the
+// `any` edge, which a lookup tries alongside the exact one.
+struct trie_node {
+    uint16_t next[256];
+    uint16_t any;
+    int16_t sig;                // index into sig_table ending here, or -1
+};
+
+struct sig_trie {
+    struct trie_node *nodes;
+    size_t n, cap;
+};
+
+static int new_node(struct sig_trie *t) {
+    if (t->n == t->cap) {
+        size_t cap = t->cap ? t->cap * 2 : 64;
+        if (cap > UINT16_MAX) return -1;
+        struct trie_node *bigger = realloc(t->nodes, cap * sizeof *bigger);
+        if (!bigger) return -1;
+        t->nodes = bigger;
+        t->cap = cap;
+    }
+    memset(&t->nodes[t->n], 0, sizeof t->nodes[0]);
+    t->nodes[t->n].sig = -1;
+    return (int)t->n++;
+}
+
+static int hex_digit(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// "89 50 ?? 47" -> {0x89, 0x50, -1, 0x47}; returns the count, -1 if malformed
+static int parse_magic(const char *magic, int *out) {
+    int n = 0;
+    for (const char *p = magic; *p; ) {
+        if (*p == ' ') { p++; continue; }
+        if (n == MAX_PATTERN) return -1;
+        if (p[0] == '?' && p[1] == '?') {
+            out[n++] = -1;
+        } else {
+            int hi = hex_digit(p[0]), lo = hi < 0 ? -1 : hex_digit(p[1]);
+            if (hi < 0 || lo < 0) return -1;
+            out[n++] = hi << 4 | lo;
+        }
+        p += 2;
+    }
+    return n;
+}
+
+// Follow (or create) the edge for one pattern byte; byte < 0 means "??"
+static int child(struct sig_trie *t, int node, int byte) {
+    uint16_t cur = byte < 0 ? t->nodes[node].any : t->nodes[node].next[byte];
+    if (cur) return cur;
+    int c = new_node(t);
+    if (c < 0) return -1;
+    // new_node may have moved nodes[], so index again
+    if (byte < 0) t->nodes[node].any = (uint16_t)c;
+    else t->nodes[node].next[byte] = (uint16_t)c;
+    return c;
+}
+
+static int add_sig(struct sig_trie *t, size_t id) {
+    const struct sig *s = &sig_table[id];
+    int bytes[MAX_PATTERN];
+    int n = parse_magic(s->magic, bytes);
+    if (n <= 0) return -1;
+    int node = 0;
+    // a pattern at offset N is N "??" bytes followed by the pattern
+    for (size_t i = 0; i < s->offset && node >= 0; i++) node = child(t, node, -1);
+    for (int i = 0; i < n && node >= 0; i++) node = child(t, node, bytes[i]);
+    if (node < 0) return -1;
+    if (t->nodes[node].sig < 0) t->nodes[node].sig = (int16_t)id;
+    return 0;
+}
+
+struct sig_trie *sig_trie_build(void) {
+    struct sig_trie *t = calloc(1, sizeof *t);
+    if (!t || new_node(t) < 0) {
+        sig_trie_free(t);
+        return NULL;
+    }
+    for (size_t i = 0; i < sig_count; i++) {
+        if (add_sig(t, i) != 0) {
+            sig_trie_free(t);
+            return NULL;
+        }
+    }
+    return t;
+}
+
+void sig_trie_free(struct sig_trie *t) {
+    if (!t) return;
+    free(t->nodes);
+    free(t);
+}
+
+struct best {
+    int sig;
+    size_t depth;
+};
+
+static void walk(const struct sig_trie *t, int node, const unsigned char *buf,
+                 size_t pos, size_t len, struct best *b) {
+    for (;;) {
+        const struct trie_node *nd = &t->nodes[node];
+        if (nd->sig >= 0 && (pos > b->depth || (pos == b->depth && nd->sig < b->sig))) {
+            b->sig = nd->sig;
+            b->depth = pos;
+        }
+        if (pos == len) return;
+        // exact byte first; only branch when a "??" edge is here too
+        if (nd->any) {
+            if (nd->next[buf[pos]]) walk(t, nd->next[buf[pos]], buf, pos + 1, len, b);
+            node = nd->any;
+        } else if (nd->next[buf[pos]]) {
+            node = nd->next[buf[pos]];
+        } else {
+            return;
+        }
+        pos++;
+    }
+}
+
+const struct sig *sig_identify(const struct sig_trie *t, const unsigned char *buf, size_t len) {
+    struct best b = { .sig = -1, .depth = 0 };
+    walk(t, 0, buf, 0, len, &b);
+    return b.sig < 0 ? NULL : &sig_table[b.sig];
+}
+
+// Aho-Corasick, stored as a full state machine: next[c] is where byte c goes
+// from every state, failure links already folded in, so scanning is one
+// table lookup per byte with no backtracking.
+struct ac_node {
+    uint16_t next[256];
+    uint16_t fail;
+    uint16_t dict;              // nearest state down the fail chain that ends a pattern
+    int16_t match;              // pattern ending exactly here, or -1
+};
+
+struct sig_ac {
+    struct ac_node *nodes;
+    size_t n, cap;
+    size_t *lens;               // pattern lengths, to turn match ends into starts
+    size_t maxlen;
+    unsigned char first[256];   // bytes that can start a pattern
+    unsigned char firsts[8];    // the same as a list, when there are few of them
+    int nfirsts;                // 0 = too many for the list
+};
+
+static int ac_new_node(struct sig_ac *ac) {
+    if (ac->n == ac->cap) {
+        size_t cap = ac->cap ? ac->cap * 2 : 64;
+        if (cap > UINT16_MAX) return -1;
+        struct ac_node *bigger = realloc(ac->nodes, cap * sizeof *bigger);
+        if (!bigger) return -1;
+        ac->nodes = bigger;
+        ac->cap = cap;
+    }
+    memset(&ac->nodes[ac->n], 0, sizeof ac->nodes[0]);
+    ac->nodes[ac->n].match = -1;
+    return (int)ac->n++;
+}
+
+struct sig_ac *sig_ac_build(const char *const *patterns, size_t n) {
+    struct sig_ac *ac = calloc(1, sizeof *ac);
+    if (!ac || !(ac->lens = calloc(n ? n : 1, sizeof *ac->lens)) || ac_new_node(ac) < 0) {
+        sig_ac_free(ac);
+        return NULL;
+    }
+
+    // 1. plain trie of the patterns
+    for (size_t id = 0; id < n; id++) {
+        int bytes[MAX_PATTERN];
+        int len = parse_magic(patterns[id], bytes);
+        if (len <= 0) { sig_ac_free(ac); return NULL; }
+        int node = 0;
+        for (int i = 0; i < len; i++) {
+            if (bytes[i] < 0) { sig_ac_free(ac); return NULL; } // no "??" here
+            uint16_t nx = ac->nodes[node].next[bytes[i]];
+            if (!nx) {
+                int c = ac_new_node(ac);
+                if (c < 0) { sig_ac_free(ac); return NULL; }
+                ac->nodes[node].next[bytes[i]] = (uint16_t)c;
+                nx = (uint16_t)c;
+            }
+            node = nx;
+        }
+        if (ac->nodes[node].match < 0) ac->nodes[node].match = (int16_t)id;
+        ac->lens[id] = (size_t)len;
+        if ((size_t)len > ac->maxlen) ac->maxlen = (size_t)len;
+        ac->first[bytes[0]] = 1;
+    }
+
+    // 2. breadth-first: fail links, then fill in the missing edges. Nodes
+    //    were created in insertion order, not by depth, so keep a queue.
+    uint16_t *queue = malloc(ac->n * sizeof *queue);
+    if (!queue) { sig_ac_free(ac); return NULL; }
+    size_t head = 0, tail = 0;
+    for (int c = 0; c < 256; c++) {
+        uint16_t nx = ac->nodes[0].next[c];
+        if (nx) queue[tail++] = nx;     // depth 1: fail to the root
+    }
+    while (head < tail) {
+        uint16_t s = queue[head++];
+        struct ac_node *nd = &ac->nodes[s];
+        const struct ac_node *f = &ac->nodes[nd->fail];
+        nd->dict = f->match >= 0 ? nd->fail : f->dict;
+        for (int c = 0; c < 256; c++) {
+            uint16_t nx = nd->next[c];
+            if (nx) {
+                ac->nodes[nx].fail = f->next[c];
+                queue[tail++] = nx;
+            } else {
+                nd->next[c] = f->next[c];
+            }
+        }
+    }
+    free(queue);
+
+    for (int c = 0; c < 256; c++) {
+        if (!ac->first[c]) continue;
+        if (ac->nfirsts == (int)sizeof ac->firsts) { ac->nfirsts = 0; break; }
+        ac->firsts[ac->nfirsts++] = (unsigned char)c;
+    }
+    return ac;
+}
+
+void sig_ac_free(struct sig_ac *ac) {
+    if (!ac) return;
+    free(ac->nodes);
+    free(ac->lens);
+    free(ac);
+}
+
+size_t sig_ac_maxlen(const struct sig_ac *ac) {
+    return ac->maxlen;
+}
+
+// From the root, nothing can happen until a byte that starts some pattern.
+// Images are mostly zeros, text and compressed data, so jump there fast:
+// 16 bytes per step against each possible first byte when there are only a
+// few of them, else a table lookup per byte.
+static size_t skip_to_first(const struct sig_ac *ac, const unsigned char *buf, size_t i, size_t len) {
+#ifdef __SSE2__
+    if (ac->nfirsts) {
+        __m128i want[8];
+        for (int k = 0; k < ac->nfirsts; k++) want[k] = _mm_set1_epi8((char)ac->firsts[k]);
+        for (; i + 16 <= len; i += 16) {
+            __m128i v = _mm_loadu_si128((const __m128i *)(buf + i));
+            __m128i hit = _mm_cmpeq_epi8(v, want[0]);
+            for (int k = 1; k < ac->nfirsts; k++) hit = _mm_or_si128(hit, _mm_cmpeq_epi8(v, want[k]));
+            int m = _mm_movemask_epi8(hit);
+            if (m) return i + (size_t)__builtin_ctz((unsigned)m);
+        }
+    }
+#endif
+    while (i < len && !ac->first[buf[i]]) i++;
+    return i;
+}
+
+void sig_ac_scan(const struct sig_ac *ac, const unsigned char *buf, size_t len,
+                 sig_ac_hit hit, void *ctx) {
+    const struct ac_node *nodes = ac->nodes;
+    unsigned s = 0;
+    size_t i = 0;
+    while (i < len) {
+        if (s == 0) {
+            i = skip_to_first(ac, buf, i, len);
+            if (i == len) break;
+        }
+        s = nodes[s].next[buf[i++]];
+        const struct ac_node *nd = &nodes[s];
+        if (nd->match >= 0) hit(ctx, (size_t)nd->match, i - ac->lens[nd->match]);
+        for (unsigned d = nd->dict; d; d = nodes[d].dict) {
+            hit(ctx, (size_t)nodes[d].match, i - ac->lens[nodes[d].match]);
+        }
+    }
+}
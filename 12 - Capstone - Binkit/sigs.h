@@ -0,0 +1,44 @@
+#pragma once
+
+#include <stddef.h>
+
+// File signatures ("magic numbers"): bytes a format always puts at a fixed
+// offset, usually 0. Written the way hdx --find takes patterns: hex bytes,
+// "??" for a byte that can be anything.
+struct sig {
+    const char *name;           // "PNG image"
+    size_t offset;              // where the pattern starts in the file
+    const char *magic;          // "89 50 4E 47 0D 0A 1A 0A"
+};
+
+extern const struct sig sig_table[];
+extern const size_t sig_count;
+
+// How many leading bytes sig_identify can look at (covers every offset+magic)
+enum { SIG_HEADER_MAX = 512 };
+
+// All of sig_table compiled into one trie, so identifying a header is a
+// single walk over its bytes instead of a compare per signature.
+struct sig_trie;
+
+struct sig_trie *sig_trie_build(void);
+void sig_trie_free(struct sig_trie *t);
+
+// Most specific signature matching the first len bytes of a file (the one
+// that matched the most bytes), or NULL
+const struct sig *sig_identify(const struct sig_trie *t, const unsigned char *buf, size_t len);
+
+// Aho-Corasick automaton over plain hex patterns (no "??"): finds every
+// occurrence of every pattern anywhere in a buffer in one pass, for scanning
+// disk images rather than file headers.
+struct sig_ac;
+
+struct sig_ac *sig_ac_build(const char *const *patterns, size_t n);
+void sig_ac_free(struct sig_ac *ac);
+size_t sig_ac_maxlen(const struct sig_ac *ac);   // longest pattern, in bytes
+
+// Calls hit(ctx, pattern index, offset of the match's first byte) for each
+// match in buf[0..len), in order of where the matches end.
+typedef void (*sig_ac_hit)(void *ctx, size_t pattern, size_t start);
+void sig_ac_scan(const struct sig_ac *ac, const unsigned char *buf, size_t len,
+                 sig_ac_hit hit, void *ctx);
@@ -0,0 +1,422 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "binkit.h"
+#include "util.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// binkit strings: runs of printable text, with their offsets.
+//
+// Output matches `strings -a -t x` (same printable set: 0x20-0x7E plus tab,
+// same "%7x " offset column), so the two can be diffed. --utf16 also finds
+// UTF-16LE text ("a\0b\0c\0d\0"), which is how Windows binaries and memory
+// dumps store most of their strings.
+//
+// Lines come out in the order the runs end, which is offset order except in
+// one case: with -u -n 1, single ASCII characters inside a UTF-16 run (each
+// is a run of 1 between the 0 bytes) are printed before the UTF-16 run.
+// Keeping them back until it ends would mean buffering a line per character.
+//
+// How it stays fast:
+//   * No per-byte isprint(). 64 bytes at a time become 64-bit masks
+//     ("printable", "zero") with a few SSE2 compares and movemasks.
+//   * Runs come out of the masks with count-trailing-zeros: a block that is
+//     all text (or all binary) costs one compare, and a mixed block costs
+//     one step per run edge, not per byte.
+//   * Regular files are mmapped, so nothing is copied on the way in; pipes
+//     go through a buffer that keeps the unfinished run at the front. A run
+//     longer than half that buffer is printed as it goes instead, so a
+//     multi-GB run piped in doesn't have to fit in memory.
+
+enum {
+    BLOCK = 64,
+    STREAM_BUF = 1 << 20,
+    OUT_BUF = 1 << 16,
+    MAX_HITS = 3 * BLOCK,       // runs ending in one block, all tracks
+};
+
+// One kind of run being followed across blocks. For UTF-16 the mask has both
+// bits of every (char, 0) pair set, so a run is still a stretch of 1 bits.
+struct track {
+    int in_run;
+    uint64_t start;             // where the run's bits start (absolute)
+    int parity;                 // UTF-16: pairs start on even (0) or odd (1) offsets
+    int utf16;
+    int spilled;                // stream: the line is already partly written
+    uint64_t printed;           // ...up to this offset (the next char to write)
+};
+
+struct hit {
+    uint64_t start;             // offset of the first byte
+    uint64_t len;               // bytes, including the 0s for UTF-16
+    int utf16;
+    int cont;                   // rest of a spilled run: text from `from` and '\n' only
+    uint64_t from;
+};
+
+struct out {
+    char buf[OUT_BUF];
+    size_t n;
+    int failed;
+};
+
+struct scanner {
+    size_t min_len;             // in characters
+    int utf16;
+    struct track ascii, wide[2];
+    struct hit hits[MAX_HITS];
+    size_t nhits;
+    struct out out;
+};
+
+static void out_flush(struct out *o) {
+    if (o->n && !o->failed && write_all(STDOUT_FILENO, o->buf, o->n) != 0) o->failed = 1;
+    o->n = 0;
+}
+
+// The offset column, like printf("%7llx "). Needs 24 bytes of room at q.
+static char *put_offset(char *q, uint64_t off) {
+    static const char digits[] = "0123456789abcdef";
+    char num[17];
+    int n = 0;
+    do {
+        num[16 - ++n] = digits[off & 0xF];
+        off >>= 4;
+    } while (off);
+    for (int i = n; i < 7; i++) *q++ = ' ';
+    memcpy(q, num + 16 - n, (size_t)n);
+    q += n;
+    *q++ = ' ';
+    return q;
+}
+
+static void out_prefix(struct out *o, uint64_t off) {
+    if (o->n + 24 > OUT_BUF) out_flush(o);
+    o->n = (size_t)(put_offset(o->buf + o->n, off) - o->buf);
+}
+
+// Text of any length (UTF-16: every other byte, starting with p[0]); big
+// ASCII pieces go straight from the input
+static void out_text(struct out *o, const unsigned char *p, uint64_t len, int utf16) {
+    if (!utf16 && len > OUT_BUF - o->n) {
+        out_flush(o);
+        if (!o->failed && write_all(STDOUT_FILENO, p, (size_t)len) != 0) o->failed = 1;
+        return;
+    }
+    if (!utf16) {
+        memcpy(o->buf + o->n, p, (size_t)len);
+        o->n += (size_t)len;
+        return;
+    }
+    for (uint64_t i = 0; i < len; i += 2) {
+        if (o->n == OUT_BUF) out_flush(o);
+        o->buf[o->n++] = (char)p[i];
+    }
+}
+
+static void out_newline(struct out *o) {
+    if (o->n == OUT_BUF) out_flush(o);
+    o->buf[o->n++] = '\n';
+}
+
+// One line: offset, then the text
+static void out_line(struct out *o, uint64_t off, const unsigned char *p, uint64_t len, int utf16) {
+    uint64_t chars = utf16 ? len / 2 : len;
+    if (o->n + 24 + chars > OUT_BUF) out_flush(o);
+    if (chars + 24 > OUT_BUF) {
+        // a huge run: doesn't fit the buffer even when it's empty
+        out_prefix(o, off);
+        out_text(o, p, len, utf16);
+        out_newline(o);
+        return;
+    }
+
+    char *q = put_offset(o->buf + o->n, off);
+    if (utf16) {
+        for (uint64_t i = 0; i < len; i += 2) *q++ = (char)p[i];
+    } else {
+        memcpy(q, p, (size_t)len);
+        q += len;
+    }
+    *q++ = '\n';
+    o->n = (size_t)(q - o->buf);
+}
+
+// Masks for 64 bytes: bit i of *print is set when p[i] is printable, bit i of
+// *zero when p[i] == 0.
+#ifdef __SSE2__
+static inline void classify(const unsigned char *p, uint64_t *print, uint64_t *zero) {
+    const __m128i lo = _mm_set1_epi8(0x1F);
+    const __m128i hi = _mm_set1_epi8(0x7F);
+    const __m128i tab = _mm_set1_epi8('\t');
+    const __m128i nul = _mm_setzero_si128();
+    uint64_t pm = 0, zm = 0;
+    for (int k = 0; k < 4; k++) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(p + 16 * k));
+        // signed compares: bytes >= 0x80 are negative, so they fail "> 0x1F"
+        __m128i pr = _mm_and_si128(_mm_cmpgt_epi8(v, lo), _mm_cmplt_epi8(v, hi));
+        pr = _mm_or_si128(pr, _mm_cmpeq_epi8(v, tab));
+        pm |= (uint64_t)(uint16_t)_mm_movemask_epi8(pr) << (16 * k);
+        zm |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, nul)) << (16 * k);
+    }
+    *print = pm;
+    *zero = zm;
+}
+#else
+static inline void classify(const unsigned char *p, uint64_t *print, uint64_t *zero) {
+    uint64_t pm = 0, zm = 0;
+    for (int i = 0; i < BLOCK; i++) {
+        unsigned char c = p[i];
+        pm |= (uint64_t)((c >= 0x20 && c < 0x7F) || c == '\t') << i;
+        zm |= (uint64_t)(c == 0) << i;
+    }
+    *print = pm;
+    *zero = zm;
+}
+#endif
+
+static void add_hit(struct scanner *sc, struct track *t, uint64_t end) {
+    uint64_t len = end - t->start;
+    uint64_t chars = t->utf16 ? len / 2 : len;
+    if (chars < sc->min_len && !t->spilled) return;
+    struct hit *h = &sc->hits[sc->nhits++];
+    h->start = t->start + (uint64_t)t->parity;
+    h->len = len;
+    h->utf16 = t->utf16;
+    h->cont = t->spilled;
+    h->from = t->printed;
+    t->spilled = 0;
+}
+
+// Walk the 0->1 and 1->0 edges of one block's mask
+static void scan_mask(struct scanner *sc, struct track *t, uint64_t m, uint64_t off) {
+    if (t->in_run ? m == UINT64_MAX : m == 0) return;
+    unsigned bit = 0;
+    for (;;) {
+        uint64_t rest = (t->in_run ? ~m : m) & (UINT64_MAX << bit);
+        if (rest == 0) return;
+        bit = (unsigned)__builtin_ctzll(rest);
+        if (t->in_run) {
+            add_hit(sc, t, off + bit);
+            t->in_run = 0;
+        } else {
+            t->start = off + bit;
+            t->in_run = 1;
+        }
+    }
+}
+
+// Print this block's finished runs in the order they end (blocks are done
+// in order, so sorting the few that end in one block is enough).
+static void flush_hits(struct scanner *sc, const unsigned char *buf, uint64_t base) {
+    for (size_t i = 1; i < sc->nhits; i++) {
+        struct hit h = sc->hits[i];
+        size_t j = i;
+        for (; j > 0 && sc->hits[j - 1].start + sc->hits[j - 1].len > h.start + h.len; j--) {
+            sc->hits[j] = sc->hits[j - 1];
+        }
+        sc->hits[j] = h;
+    }
+    for (size_t i = 0; i < sc->nhits; i++) {
+        const struct hit *h = &sc->hits[i];
+        if (h->cont) {
+            out_text(&sc->out, buf + (h->from - base), h->start + h->len - h->from, h->utf16);
+            out_newline(&sc->out);
+        } else {
+            out_line(&sc->out, h->start, buf + (h->start - base), h->len, h->utf16);
+        }
+    }
+    sc->nhits = 0;
+}
+
+// One 64-byte block at p; `next` is the byte after it (needed to see
+// whether the last byte starts a UTF-16 pair)
+static void scan_block(struct scanner *sc, const unsigned char *p, unsigned char next, uint64_t off) {
+    uint64_t print, zero;
+    classify(p, &print, &zero);
+    scan_mask(sc, &sc->ascii, print, off);
+    if (sc->utf16) {
+        // bit i: p[i] printable and p[i+1] == 0
+        uint64_t pairs = print & ((zero >> 1) | ((uint64_t)(next == 0) << 63));
+        uint64_t even = pairs & 0x5555555555555555ULL;
+        uint64_t odd = pairs & 0xAAAAAAAAAAAAAAAAULL;
+        scan_mask(sc, &sc->wide[0], even | (even << 1), off);
+        // odd pairs are shifted down a bit so both halves stay in this block
+        // (track.parity adds it back)
+        scan_mask(sc, &sc->wide[1], odd | (odd >> 1), off);
+    }
+}
+
+// Scan buf[pos..len) (buf[0] is at offset `base`) a block at a time. Unless
+// `final`, a block needs one byte after it, so up to 64 bytes can be left for
+// the next call. With `final` the tail is padded with 0xFF (neither text nor
+// 0), which also closes any run still open. Returns where scanning stopped.
+static size_t scan(struct scanner *sc, const unsigned char *buf, uint64_t base,
+                   size_t pos, size_t len, int final) {
+    for (; pos + BLOCK < len; pos += BLOCK) {
+        scan_block(sc, buf + pos, buf[pos + BLOCK], base + pos);
+        if (sc->nhits) flush_hits(sc, buf, base);
+    }
+    if (!final) return pos;
+
+    // last block (possibly empty), then one all-padding block if the input
+    // ended exactly on a block edge
+    for (;;) {
+        unsigned char tail[BLOCK];
+        size_t n = len - pos;
+        memset(tail, 0xFF, sizeof tail);
+        memcpy(tail, buf + pos, n);
+        scan_block(sc, tail, 0xFF, base + pos);
+        if (sc->nhits) flush_hits(sc, buf, base);
+        if (n < BLOCK) break;
+        pos += n;
+    }
+    return len;
+}
+
+// Write what an open run has so far (everything before `upto`), leaving the
+// rest of its line for add_hit. Only once the run is certain to be printed.
+static void spill(struct scanner *sc, struct track *t, const unsigned char *buf,
+                  uint64_t base, uint64_t upto) {
+    if (!t->in_run || upto - t->start < STREAM_BUF / 2) return;
+    if (!t->spilled) {
+        uint64_t chars = t->utf16 ? (upto - t->start) / 2 : upto - t->start;
+        if (chars < sc->min_len) return;
+        out_prefix(&sc->out, t->start + (uint64_t)t->parity);
+        t->printed = t->start + (uint64_t)t->parity;
+        t->spilled = 1;
+    }
+    if (t->printed >= upto) return;
+    uint64_t len = upto - t->printed;
+    if (t->utf16) len = (len + 1) & ~(uint64_t)1;   // chars before upto
+    out_text(&sc->out, buf + (t->printed - base), len, t->utf16);
+    t->printed += len;
+}
+
+// The earliest byte a still-open run needs, or `pos` if none is open
+static size_t keep_from(const struct scanner *sc, uint64_t base, size_t pos) {
+    uint64_t keep = base + pos;
+    const struct track *t[3] = { &sc->ascii, &sc->wide[0], &sc->wide[1] };
+    for (int k = 0; k < 3; k++) {
+        if (!t[k]->in_run) continue;
+        uint64_t need = t[k]->spilled ? t[k]->printed : t[k]->start;
+        if (need < keep) keep = need;
+    }
+    return (size_t)(keep - base);
+}
+
+// Pipes and such: read into a buffer, scan what's there, slide the unscanned
+// bytes and any unfinished run to the front, read more. Only moves whole
+// blocks so offsets stay block-aligned (the UTF-16 parity depends on it).
+static int scan_stream(struct scanner *sc, int fd) {
+    size_t cap = STREAM_BUF, len = 0, pos = 0;
+    uint64_t base = 0;
+    unsigned char *buf = malloc(cap);
+    if (!buf) { perror("malloc"); return -1; }
+
+    for (;;) {
+        if (len == cap) {
+            // one run fills the whole buffer and can't be written out yet
+            // (shorter than -n, or UTF-16 with -n 1): make room
+            unsigned char *bigger = realloc(buf, cap * 2);
+            if (!bigger) { perror("realloc"); free(buf); return -1; }
+            buf = bigger;
+            cap *= 2;
+        }
+        ssize_t got = read_full(fd, buf + len, cap - len);
+        if (got < 0) { perror("read"); free(buf); return -1; }
+        len += (size_t)got;
+        if (got == 0) {
+            scan(sc, buf, base, pos, len, 1);
+            break;
+        }
+        pos = scan(sc, buf, base, pos, len, 0);
+
+        // With -n 1 a one-character ASCII run can end inside a UTF-16 run,
+        // and it can't be printed in the middle of that run's line, so a
+        // UTF-16 run is only written early when nothing can end inside it.
+        spill(sc, &sc->ascii, buf, base, base + pos);
+        if (sc->min_len > 1) {
+            spill(sc, &sc->wide[0], buf, base, base + pos);
+            spill(sc, &sc->wide[1], buf, base, base + pos);
+        }
+        size_t keep = keep_from(sc, base, pos) / BLOCK * BLOCK;
+        memmove(buf, buf + keep, len - keep);
+        base += keep;
+        pos -= keep;
+        len -= keep;
+    }
+    free(buf);
+    return 0;
+}
+
+static void strings_usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [file] [-n MIN] [--utf16]\n", prog);
+    fprintf(stderr, "  -n, --min N   shortest run to print, in characters (default 4)\n");
+    fprintf(stderr, "  -u, --utf16   also find UTF-16LE text\n");
+    fprintf(stderr, "  Each line: hex offset, then the text (like strings -a -t x).\n");
+}
+
+int cmd_strings(int argc, char **argv) {
+    const char *path = NULL;
+    struct scanner *sc = calloc(1, sizeof *sc);
+    if (!sc) { perror("calloc"); return 1; }
+    sc->min_len = 4;
+
+    for (int i = 1; i < argc; i++) {
+        const char *a = argv[i];
+        if (strcmp(a, "-n") == 0 || strcmp(a, "--min") == 0) {
+            if (i + 1 >= argc || parse_size(argv[i + 1], &sc->min_len) != 0 || sc->min_len == 0) {
+                fprintf(stderr, "%s needs a length above 0\n", a);
+                free(sc);
+                return 1;
+            }
+            i++;
+        } else if (strcmp(a, "-u") == 0 || strcmp(a, "--utf16") == 0) {
+            sc->utf16 = 1;
+        } else if (strcmp(a, "-h") == 0 || strcmp(a, "--help") == 0) {
+            strings_usage(argv[0]);
+            free(sc);
+            return 0;
+        } else if (a[0] == '-' && a[1] != '\0') {
+            fprintf(stderr, "Unknown option: %s\n", a);
+            strings_usage(argv[0]);
+            free(sc);
+            return 1;
+        } else if (!path) {
+            path = a;
+        } else {
+            fprintf(stderr, "Only one file, please\n");
+            free(sc);
+            return 1;
+        }
+    }
+    sc->wide[0].utf16 = sc->wide[1].utf16 = 1;
+    sc->wide[1].parity = 1;
+
+    int fd = open_input(path);
+    if (fd < 0) { perror("open"); free(sc); return 1; }
+
+    int rc = 0;
+    size_t len;
+    const unsigned char *map = map_input(fd, &len);
+    if (map) {
+        scan(sc, map, 0, 0, len, 1);
+        munmap((void *)map, len);
+    } else if (scan_stream(sc, fd) != 0) {
+        rc = 1;
+    }
+    out_flush(&sc->out);
+    if (sc->out.failed) { perror("write"); rc = 1; }
+
+    free(sc);
+    if (fd != STDIN_FILENO) close(fd);
+    return rc;
+}
@@ -0,0 +1,80 @@
+#define _POSIX_C_SOURCE 200809L
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "util.h"
+
+int open_input(const char *path) {
+    if (!path || strcmp(path, "-") == 0) return STDIN_FILENO;
+    return open(path, O_RDONLY);
+}
+
+// Keep reading until the block is full or the input ends, so callers get
+// whole blocks even when a pipe hands us dribbles.
+ssize_t read_full(int fd, void *buf, size_t want) {
+    unsigned char *p = buf;
+    size_t have = 0;
+    while (have < want) {
+        ssize_t r = read(fd, p + have, want - have);
+        if (r < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        if (r == 0) break;
+        have += (size_t)r;
+    }
+    return (ssize_t)have;
+}
+
+int write_all(int fd, const void *buf, size_t n) {
+    const char *p = buf;
+    while (n > 0) {
+        ssize_t w = write(fd, p, n);
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        p += w;
+        n -= (size_t)w;
+    }
+    return 0;
+}
+
+int parse_size(const char *s, size_t *out) {
+    char *end = NULL;
+    errno = 0;
+    unsigned long long v = strtoull(s, &end, 0);
+    if (end == s || s[0] == '-' || errno == ERANGE) {
+        errno = EINVAL;
+        return -1;
+    }
+    unsigned shift = 0;
+    switch (*end) {
+    case 'k': case 'K': shift = 10; end++; break;
+    case 'm': case 'M': shift = 20; end++; break;
+    case 'g': case 'G': shift = 30; end++; break;
+    default: break;
+    }
+    if (*end != '\0' || (shift && v > (SIZE_MAX >> shift))) {
+        errno = EINVAL;
+        return -1;
+    }
+    *out = (size_t)(v << shift);
+    return 0;
+}
+
+const unsigned char *map_input(int fd, size_t *len) {
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= 0) return NULL;
+    if ((uint64_t)st.st_size > SIZE_MAX) return NULL;
+    void *p = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (p == MAP_FAILED) return NULL;
+    posix_madvise(p, (size_t)st.st_size, POSIX_MADV_SEQUENTIAL);
+    *len = (size_t)st.st_size;
+    return p;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <stddef.h>
+#include <sys/types.h>  // ssize_t
+
+// Small helpers every subcommand ends up needing. All of them report
+// failure with -1 and leave errno set, so callers can perror().
+
+// Open path for reading; NULL or "-" means stdin.
+int open_input(const char *path);
+
+// read() until want bytes arrived or the input ended (short only at EOF)
+ssize_t read_full(int fd, void *buf, size_t want);
+
+// write() all n bytes, riding out short writes and EINTR
+int write_all(int fd, const void *buf, size_t n);
+
+// "4096", "0x1000", "64K", "1M", "2G" -> bytes
+int parse_size(const char *s, size_t *out);
+
+// Map a whole regular file read-only for a front-to-back scan. NULL when fd
+// isn't a non-empty regular file or mmap refuses; callers then fall back to
+// read(). Release with munmap(p, *len).
+const unsigned char *map_input(int fd, size_t *len);
@@ -0,0 +1,41 @@
+#!/bin/sh
+# bench_parallel.sh - hdx -j scaling on a multi-GB file
+#
+# Build hdx first (from "13 - Hdx Dumper"):
+#   gcc -std=c17 -O2 -Wall -Wextra -pthread -o hdx hdx.c
+# Run:
+#   sh bench/bench_parallel.sh [size_mb] [jobs...]
+#   e.g. sh bench/bench_parallel.sh 2048 1 2 4 8
+#
+# Makes a random test file (random data so squeezing can't shortcut anything),
+# times each -j setting with output to /dev/null, and checks every parallel
+# run is byte-identical to -j 1.
+
+set -e
+
+HDX=${HDX:-./hdx}
+SIZE_MB=${1:-2048}
+[ $# -gt 0 ] && shift
+JOBS=${*:-"1 2 4 8"}
+DATA=${TMPDIR:-/tmp}/hdx_bench_$$.bin
+
+cleanup() { rm -f "$DATA"; }
+trap cleanup EXIT INT TERM
+
+echo "creating ${SIZE_MB} MB of random data in $DATA"
+head -c $((SIZE_MB * 1024 * 1024)) /dev/urandom > "$DATA"
+
+REF=$("$HDX" "$DATA" -j 1 | md5sum | cut -d' ' -f1)
+
+printf '%-6s %10s %12s %s\n' jobs seconds "MB/s in" output
+for j in $JOBS; do
+    start=$(date +%s.%N)
+    "$HDX" "$DATA" -j "$j" > /dev/null
+    end=$(date +%s.%N)
+
+    sum=$("$HDX" "$DATA" -j "$j" | md5sum | cut -d' ' -f1)
+    [ "$sum" = "$REF" ] && same=identical || same=DIFFERS
+
+    awk -v j="$j" -v s="$start" -v e="$end" -v mb="$SIZE_MB" -v same="$same" \
+        'BEGIN { t = e - s; printf "%-6s %10.2f %12.1f %s\n", j, t, mb / t, same }'
+done
@@ -1,34 +1,138 @@
 // hexdump.c (single-file refactor)
+// Build: gcc -std=c17 -O2 -Wall -Wextra -pthread -o hdx hdx.c
+#define _GNU_SOURCE // SEEK_DATA / SEEK_HOLE
 #include <stdio.h>
 #include <stdint.h>
 #include <inttypes.h>
 #include <string.h>
-#include <ctype.h>
 #include <stdlib.h>
 #include <errno.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <pthread.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>   // SSSE3 hex decoder for -r (runtime-checked)
+#endif
 
-enum { LINE_WIDTH = 16 };
+enum {
+    LINE_WIDTH = 16,
+    ROW_CHARS  = 93,           // "Offset " + 16 + ": " + 16*3 + " |" + 16 + "|\n"
+    BLOCK_SIZE = 64 * 1024     // bytes read per block (multiple of LINE_WIDTH)
+};
 
-static uint64_t parse_bytes(const char *str) {
-    if (!str || !*str) {
-        fprintf(stderr, "Missing value for -n! Defaulting to reading entire file.\n");
+// Where the bytes come from. Regular files and block devices are read with
+// pread at the exact offset we want; pipes/ttys can only go forward, so we
+// track how far we've consumed and skip-read up to a range start.
+struct input {
+    int fd;
+    int seekable;   // 1 = pread works, jump anywhere
+    uint64_t pos;   // next unread offset (only meaningful when !seekable)
+    int sparse;     // 1 = regular file, SEEK_DATA can find the end of a hole
+    uint64_t size;  // size when seekable (0 if unknown)
+};
 
+// hexdump -C style squeezing: a row identical to the one before it prints
+// as a single "*" line for the whole run instead of being repeated.
+struct squeeze {
+    int enabled;                        // 0 with -v
+    int have_prev;                      // prev holds the last full row
+    int squeezing;                      // inside a run, "*" already printed
+    int prev_zero;                      // prev is all zero bytes (fast path)
+    unsigned char prev[LINE_WIDTH];
+};
+
+// A byte range to dump; len == UINT64_MAX means "to EOF"
+struct range {
+    uint64_t start;
+    uint64_t len;
+};
+
+// Lookup tables so formatting a byte is a copy, not a printf:
+//   hex_pair[b] = "XX " for byte b, ascii_char[b] = b if printable else '.'
+static char hex_pair[256][3];
+static char ascii_char[256];
+static const char hex_digits[] = "0123456789ABCDEF";
+
+static void init_tables(void) {
+    for (int b = 0; b < 256; b++) {
+        hex_pair[b][0] = hex_digits[b >> 4];
+        hex_pair[b][1] = hex_digits[b & 0xF];
+        hex_pair[b][2] = ' ';
+        ascii_char[b] = (b >= 0x20 && b < 0x7F) ? (char)b : '.'; // isprint() in the C locale
+    }
+}
+
+// Parse an offset/length for -s, -n and --range:
+//   decimal ("4096"), hex ("0x1000"), with an optional K/M/G suffix (x1024)
+// Exits on garbage, since dumping the wrong place silently is worse than stopping.
+static uint64_t parse_offset(const char *str, const char *what) {
+    int base = 10;
+    const char *digits = str;
+    if (str[0] == '0' && (str[1] == 'x' || str[1] == 'X')) {
+        base = 16;
+        digits = str + 2;
     }
     errno = 0;
     char *end = NULL;
-    unsigned long long v = strtoull(str, &end, 10);
-
-    // full-string numeric check
-    if (end == str || *end != '\0') {
-        fprintf(stderr, "Invalid -n value: '%s'! Defaulting to reading entire file.\n", str);
+    unsigned long long v = strtoull(digits, &end, base);
+    if (end == digits || *digits == '-' || *digits == '+' || errno == ERANGE) {
+        fprintf(stderr, "Invalid %s value: '%s'\n", what, str);
+        exit(EXIT_FAILURE);
+    }
 
+    unsigned shift = 0;
+    switch (*end) {
+    case 'k': case 'K': shift = 10; end++; break;
+    case 'm': case 'M': shift = 20; end++; break;
+    case 'g': case 'G': shift = 30; end++; break;
+    default: break;
+    }
+    if (*end != '\0' || (shift && v > (UINT64_MAX >> shift))) {
+        fprintf(stderr, "Invalid %s value: '%s'\n", what, str);
+        exit(EXIT_FAILURE);
     }
-    if (errno == ERANGE) {
-        fprintf(stderr, "Value out of range for -n: '%s'\n", str);
+    return (uint64_t)v << shift;
+}
+
+// Parse a plain decimal count for -j and -C (no hex, no suffixes). Exits on garbage.
+static uint64_t parse_count(const char *str, const char *what) {
+    errno = 0;
+    char *end = NULL;
+    unsigned long long v = strtoull(str, &end, 10);
+    if (end == str || *str == '-' || *str == '+' || *end != '\0' || errno == ERANGE) {
+        fprintf(stderr, "Invalid %s value: '%s'\n", what, str);
+        exit(EXIT_FAILURE);
     }
     return (uint64_t)v;
 }
 
+// "--range START:LEN" (LEN may be empty = to EOF)
+static struct range parse_range(const char *str) {
+    const char *colon = strchr(str, ':');
+    if (!colon || colon == str) {
+        fprintf(stderr, "Invalid --range value: '%s' (expected START:LEN)\n", str);
+        exit(EXIT_FAILURE);
+    }
+    char start[64];
+    size_t n = (size_t)(colon - str);
+    if (n >= sizeof start) {
+        fprintf(stderr, "Invalid --range value: '%s'\n", str);
+        exit(EXIT_FAILURE);
+    }
+    memcpy(start, str, n);
+    start[n] = '\0';
+
+    struct range r;
+    r.start = parse_offset(start, "--range start");
+    r.len = colon[1] ? parse_offset(colon + 1, "--range length") : UINT64_MAX;
+    return r;
+}
+
 static FILE* open_stream(const char *path) {
     if (path == NULL) return stdin;
     FILE *fp = fopen(path, "rb");
@@ -39,74 +143,1478 @@ static FILE* open_stream(const char *path) {
     return fp;
 }
 
-static void print_line(uint64_t offset, const unsigned char *buf, size_t got) {
-    // Offset
-    printf("Offset %016" PRIx64 ": ", offset);
+// Render one row into dst; same layout the old printf version produced:
+//   Offset 0000000000000010: 48 65 6C ... |Hel...|
+// returns: number of chars written (always ROW_CHARS)
+static size_t format_row(char *dst, uint64_t offset, const unsigned char *buf, size_t got) {
+    char *p = dst;
+    memcpy(p, "Offset ", 7);
+    p += 7;
+    for (int shift = 60; shift >= 0; shift -= 4) {
+        *p++ = "0123456789abcdef"[(offset >> shift) & 0xF]; // offset stays lowercase like PRIx64
+    }
+    *p++ = ':';
+    *p++ = ' ';
 
     // Hex bytes
     for (size_t i = 0; i < got; i++) {
-        printf("%02X ", buf[i]);
+        memcpy(p, hex_pair[buf[i]], 3);
+        p += 3;
     }
     // pad if short read
-    for (size_t i = got; i < LINE_WIDTH; i++) {
-        printf("   ");
-    }
+    memset(p, ' ', (LINE_WIDTH - got) * 3);
+    p += (LINE_WIDTH - got) * 3;
 
     // ASCII
-    putchar(' ');
-    putchar('|');
+    *p++ = ' ';
+    *p++ = '|';
     for (size_t i = 0; i < got; i++) {
-        unsigned char c = buf[i];
-        putchar(isprint(c) ? (char)c : '.');
+        *p++ = ascii_char[buf[i]];
     }
     // pad ASCII column too, so right border lines up
-    for (size_t i = got; i < LINE_WIDTH; i++) {
-        putchar(' ');
+    memset(p, ' ', LINE_WIDTH - got);
+    p += LINE_WIDTH - got;
+    *p++ = '|';
+    *p++ = '\n';
+    return (size_t)(p - dst);
+}
+
+// One 128-bit compare for a whole row when we have SSE2, memcmp otherwise
+static int rows_equal(const unsigned char *a, const unsigned char *b) {
+#ifdef __SSE2__
+    __m128i x = _mm_loadu_si128((const __m128i *)a);
+    __m128i y = _mm_loadu_si128((const __m128i *)b);
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(x, y)) == 0xFFFF;
+#else
+    return memcmp(a, b, LINE_WIDTH) == 0;
+#endif
+}
+
+// How many leading bytes of buf are zero, in whole rows. Disk images have
+// long zero stretches, so check 64 bytes per step before going row by row.
+static size_t zero_rows(const unsigned char *buf, size_t len) {
+    size_t i = 0;
+#ifdef __SSE2__
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 64 <= len; i += 64) {
+        __m128i v = _mm_or_si128(
+            _mm_or_si128(_mm_loadu_si128((const __m128i *)(buf + i)),
+                         _mm_loadu_si128((const __m128i *)(buf + i + 16))),
+            _mm_or_si128(_mm_loadu_si128((const __m128i *)(buf + i + 32)),
+                         _mm_loadu_si128((const __m128i *)(buf + i + 48))));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(v, zero)) != 0xFFFF) break;
+    }
+#endif
+    static const unsigned char zeros[LINE_WIDTH];
+    for (; i + LINE_WIDTH <= len; i += LINE_WIDTH) {
+        if (!rows_equal(buf + i, zeros)) break;
+    }
+    return i;
+}
+
+// Render len bytes (starting at file offset `offset`) as consecutive rows,
+// squeezing repeats. dst needs room for ROW_CHARS per started row.
+static size_t format_block(struct squeeze *sq, char *dst, uint64_t offset,
+                           const unsigned char *buf, size_t len) {
+    size_t out = 0;
+    size_t i = 0;
+    while (i < len) {
+        size_t got = (len - i < LINE_WIDTH) ? len - i : LINE_WIDTH;
+
+        // only full rows take part; a short tail row is always printed
+        if (sq->enabled && got == LINE_WIDTH && sq->have_prev && rows_equal(buf + i, sq->prev)) {
+            if (!sq->squeezing) {
+                dst[out++] = '*';
+                dst[out++] = '\n';
+                sq->squeezing = 1;
+            }
+            // zero runs: jump over everything that's still zero in one go
+            i += sq->prev_zero ? zero_rows(buf + i, len - i) : LINE_WIDTH;
+            continue;
+        }
+
+        out += format_row(dst + out, offset + i, buf + i, got);
+        sq->squeezing = 0;
+        if (got == LINE_WIDTH) {
+            memcpy(sq->prev, buf + i, LINE_WIDTH);
+            sq->have_prev = 1;
+            sq->prev_zero = zero_rows(buf + i, LINE_WIDTH) == LINE_WIDTH;
+        }
+        i += got;
+    }
+    return out;
+}
+
+// Bytes from `offset` that are known to be a hole (reads as zeros) without
+// reading them, capped at `limit`. 0 when unknown or there's data right here.
+static uint64_t hole_len(const struct input *in, uint64_t offset, uint64_t limit) {
+    if (!in->sparse || offset >= in->size) return 0;
+    off_t data = lseek(in->fd, (off_t)offset, SEEK_DATA);
+    uint64_t end;
+    if (data == (off_t)-1) {
+        if (errno != ENXIO) return 0; // no SEEK_DATA support: just read
+        end = in->size;               // hole runs to EOF
+    } else {
+        end = (uint64_t)data;
+    }
+    uint64_t n = end - offset;
+    return n < limit ? n : limit;
+}
+
+// write(2) the whole buffer, riding out partial writes and EINTR
+static int write_all(int fd, const char *p, size_t n) {
+    while (n > 0) {
+        ssize_t w = write(fd, p, n);
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        p += w;
+        n -= (size_t)w;
+    }
+    return 0;
+}
+
+static void input_init(struct input *in, FILE *fp) {
+    struct stat st;
+    in->fd = fileno(fp);
+    in->pos = 0;
+    in->seekable = fstat(in->fd, &st) == 0 &&
+                   (S_ISREG(st.st_mode) || S_ISBLK(st.st_mode)) &&
+                   lseek(in->fd, 0, SEEK_CUR) != (off_t)-1;
+    in->sparse = in->seekable && S_ISREG(st.st_mode);
+    in->size = 0;
+    if (in->sparse) {
+        in->size = (uint64_t)st.st_size;
+    } else if (in->seekable) {
+        off_t end = lseek(in->fd, 0, SEEK_END); // block devices report st_size 0
+        in->size = end == (off_t)-1 ? 0 : (uint64_t)end;
+    }
+}
+
+// Fill buf with up to want bytes from offset `off`; keeps reading through
+// short reads (pipes) so rows stay 16 bytes wide until the real end of input.
+static ssize_t read_full(struct input *in, unsigned char *buf, size_t want, uint64_t off) {
+    size_t have = 0;
+    while (have < want) {
+        ssize_t r;
+        if (in->seekable) {
+            r = pread(in->fd, buf + have, want - have, (off_t)(off + have));
+        } else {
+            r = read(in->fd, buf + have, want - have);
+        }
+        if (r < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        if (r == 0) break; // EOF
+        have += (size_t)r;
+    }
+    if (!in->seekable) in->pos += have;
+    return (ssize_t)have;
+}
+
+// Pipes can't seek: read and throw away bytes until we reach `off`.
+// returns: 0 once positioned, 1 if EOF came first, -1 on read error
+static int skip_to(struct input *in, unsigned char *scratch, uint64_t off) {
+    while (in->pos < off) {
+        uint64_t gap = off - in->pos;
+        size_t want = gap < BLOCK_SIZE ? (size_t)gap : BLOCK_SIZE;
+        ssize_t got = read_full(in, scratch, want, in->pos);
+        if (got < 0) return -1;
+        if ((size_t)got < want) return 1;
     }
-    putchar('|');
-    putchar('\n');
+    return 0;
+}
+
+// Where formatted text goes: straight to fd, or appended to a memory buffer
+// (dst != NULL) that a worker fills for the writer to flush later.
+struct sink {
+    int fd;
+    char *dst;      // NULL = write(2) each block to fd
+    size_t len;     // bytes used in dst
+};
+
+// "Offset ..." line that closes a dump ending in a "*" run, like hexdump does
+static size_t format_tail(char *dst, size_t cap, uint64_t offset) {
+    int n = snprintf(dst, cap, "Offset %016" PRIx64 "\n", offset);
+    return (size_t)n;
 }
 
-static void read_and_dump(FILE *fp, uint64_t limit /* UINT64_MAX = no limit */) {
-    unsigned char buf[LINE_WIDTH];
-    uint64_t offset = 0;
+// Format [*offset, *offset + limit) through the squeeze state sq into sink.
+// buf/out are BLOCK_SIZE scratch (out unused when the sink is a buffer).
+// On return *offset is where reading stopped (EOF or end of the span).
+// returns: 0 on success (EOF inside the span is fine), -1 on I/O error
+static int dump_span(struct input *in, struct squeeze *sq, uint64_t *offset_io, uint64_t limit,
+                     unsigned char *buf, char *out, struct sink *sink) {
+    uint64_t offset = *offset_io;
+    int rc = 0;
 
     for (;;) {
         if (limit == 0) break;
 
-        size_t want = LINE_WIDTH;
+        // Already squeezing zeros on a sparse file: whatever hole follows
+        // would only extend the "*" run, so skip it without reading.
+        if (sq->squeezing && sq->prev_zero) {
+            uint64_t hole = hole_len(in, offset, limit);
+            hole -= hole % LINE_WIDTH; // stay on row boundaries
+            offset += hole;
+            if (limit != UINT64_MAX) limit -= hole;
+            if (limit == 0) break;
+        }
+
+        size_t want = BLOCK_SIZE;
         if (limit != UINT64_MAX && limit < want) {
             want = (size_t)limit;
         }
 
-        size_t got = fread(buf, 1, want, fp);
+        ssize_t got = read_full(in, buf, want, offset);
+        if (got < 0) {
+            perror("read");
+            rc = -1;
+            break;
+        }
         if (got == 0) {
-            if (ferror(fp)) perror("fread");
-            break; // EOF or error
+            break; // EOF
         }
 
-        print_line(offset, buf, got);
-        offset += got;
+        // one write per block instead of a printf per byte
+        if (sink->dst) {
+            sink->len += format_block(sq, sink->dst + sink->len, offset, buf, (size_t)got);
+        } else {
+            size_t n = format_block(sq, out, offset, buf, (size_t)got);
+            if (write_all(sink->fd, out, n) != 0) {
+                perror("write");
+                rc = -1;
+                break;
+            }
+        }
+        offset += (uint64_t)got;
 
         if (limit != UINT64_MAX) {
-            limit -= got;
-            if (limit == 0) break;
+            limit -= (uint64_t)got;
+        }
+        if ((size_t)got < want) break; // short block means EOF
+    }
+
+    *offset_io = offset;
+    return rc;
+}
+
+// ---- parallel formatting (-j) ----
+//
+// Formatting costs far more than reading, so for big seekable inputs the
+// range is cut into CHUNK_SIZE pieces that worker threads format into their
+// own buffers. The main thread writes the buffers strictly in chunk order.
+// Only `window` chunks may be in flight ahead of the writer, so memory stays
+// bounded at window * (CHUNK_SIZE / 16 * ROW_CHARS) no matter the file size.
+
+enum { CHUNK_SIZE = 512 * 1024 }; // multiple of BLOCK_SIZE and LINE_WIDTH
+
+struct slot {
+    char *text;         // formatted rows for the chunk
+    size_t len;
+    int ready;          // worker finished, writer may flush
+    int squeezing;      // chunk ended inside a "*" run
+    uint64_t end;       // offset where the chunk's reading stopped
+    int err;
+};
+
+struct par {
+    struct input *in;
+    int squeeze;
+    uint64_t start, len;
+    size_t nchunks;
+    size_t window;
+    struct slot *slots;     // chunk k lives in slots[k % window]
+
+    pthread_mutex_t mu;
+    pthread_cond_t cv;
+    size_t next;            // next chunk to hand out
+    size_t written;         // chunks flushed by the writer
+    int stop;               // writer hit an error, workers should quit
+};
+
+// Rebuild the squeeze state single-threaded output would have at `offset`.
+// It only depends on the two rows before it: the last row (what we compare
+// against) and whether that row was itself a repeat ("*" already printed).
+static void seed_squeeze(struct input *in, struct squeeze *sq, uint64_t start, uint64_t offset) {
+    unsigned char two[2 * LINE_WIDTH];
+    if (!sq->enabled || offset - start < 2 * LINE_WIDTH) return;
+    if (read_full(in, two, sizeof two, offset - sizeof two) != (ssize_t)sizeof two) return;
+
+    memcpy(sq->prev, two + LINE_WIDTH, LINE_WIDTH);
+    sq->have_prev = 1;
+    sq->prev_zero = zero_rows(sq->prev, LINE_WIDTH) == LINE_WIDTH;
+    sq->squeezing = rows_equal(two, two + LINE_WIDTH);
+}
+
+static void *par_worker(void *arg) {
+    struct par *p = arg;
+    unsigned char *buf = malloc(BLOCK_SIZE);
+
+    for (;;) {
+        pthread_mutex_lock(&p->mu);
+        size_t k = p->next;
+        if (k >= p->nchunks || p->stop || !buf) {
+            pthread_mutex_unlock(&p->mu);
+            break;
+        }
+        p->next++;
+        // don't run more than `window` chunks ahead of the writer
+        while (k >= p->written + p->window && !p->stop) {
+            pthread_cond_wait(&p->cv, &p->mu);
+        }
+        int stop = p->stop;
+        pthread_mutex_unlock(&p->mu);
+        if (stop) break;
+
+        struct slot *sl = &p->slots[k % p->window];
+        uint64_t offset = p->start + (uint64_t)k * CHUNK_SIZE;
+        uint64_t limit = p->len - (uint64_t)k * CHUNK_SIZE;
+        if (limit > CHUNK_SIZE) limit = CHUNK_SIZE;
+
+        struct squeeze sq = { .enabled = p->squeeze };
+        seed_squeeze(p->in, &sq, p->start, offset);
+        struct sink sink = { .fd = -1, .dst = sl->text, .len = 0 };
+        int err = dump_span(p->in, &sq, &offset, limit, buf, NULL, &sink);
+
+        pthread_mutex_lock(&p->mu);
+        sl->len = sink.len;
+        sl->squeezing = sq.squeezing;
+        sl->end = offset;
+        sl->err = err;
+        sl->ready = 1;
+        pthread_cond_broadcast(&p->cv);
+        pthread_mutex_unlock(&p->mu);
+    }
+
+    if (!buf) {
+        perror("malloc");
+        // let the writer notice instead of waiting forever on our chunks
+        pthread_mutex_lock(&p->mu);
+        p->stop = 1;
+        pthread_cond_broadcast(&p->cv);
+        pthread_mutex_unlock(&p->mu);
+    }
+    free(buf);
+    return NULL;
+}
+
+// returns: 0 on success, -1 on error, 1 if the range is too small to be worth
+// threads (caller does it single-threaded)
+static int dump_parallel(struct input *in, struct range r, int squeeze, int jobs) {
+    if (r.start >= in->size) return 1;
+    uint64_t len = in->size - r.start;
+    if (r.len < len) len = r.len;
+    size_t nchunks = (size_t)((len + CHUNK_SIZE - 1) / CHUNK_SIZE);
+    if (nchunks < 2) return 1;
+
+    struct par p = { .in = in, .squeeze = squeeze, .start = r.start, .len = len,
+                     .nchunks = nchunks, .window = 2 * (size_t)jobs };
+    if (p.window > nchunks) p.window = nchunks;
+
+    size_t cap = CHUNK_SIZE / LINE_WIDTH * ROW_CHARS;
+    p.slots = calloc(p.window, sizeof *p.slots);
+    if (!p.slots) {
+        perror("calloc");
+        return -1;
+    }
+    for (size_t i = 0; i < p.window; i++) {
+        p.slots[i].text = malloc(cap);
+        if (!p.slots[i].text) {
+            perror("malloc");
+            for (size_t j = 0; j < i; j++) free(p.slots[j].text);
+            free(p.slots);
+            return -1;
+        }
+    }
+    pthread_mutex_init(&p.mu, NULL);
+    pthread_cond_init(&p.cv, NULL);
+
+    pthread_t *tids = calloc((size_t)jobs, sizeof *tids);
+    int started = 0;
+    for (int t = 0; tids && t < jobs; t++) {
+        if (pthread_create(&tids[t], NULL, par_worker, &p) != 0) break;
+        started++;
+    }
+    if (started == 0) {
+        fprintf(stderr, "Couldn't start worker threads, dumping single-threaded\n");
+        p.stop = 1;
+    }
+
+    // Writer: flush chunks in order, handing each slot back once it's out.
+    // p.stop is only read under p.mu: a worker sets it when it can't go on.
+    int rc = 0;
+    uint64_t end = r.start;
+    int squeezing = 0;
+    int shrank = 0;
+    size_t k = 0;
+    for (; started > 0 && k < nchunks; k++) {
+        struct slot *sl = &p.slots[k % p.window];
+
+        pthread_mutex_lock(&p.mu);
+        while (!sl->ready && !p.stop) {
+            pthread_cond_wait(&p.cv, &p.mu);
+        }
+        int ready = sl->ready;
+        pthread_mutex_unlock(&p.mu);
+        if (!ready) {
+            rc = -1; // a worker gave up; the dump would be missing this chunk
+            break;
+        }
+
+        if (sl->err) {
+            rc = -1;
+        } else if (write_all(STDOUT_FILENO, sl->text, sl->len) != 0) {
+            perror("write");
+            rc = -1;
+        }
+        end = sl->end;
+        squeezing = sl->squeezing;
+        shrank = end < r.start + (uint64_t)(k + 1) * CHUNK_SIZE && k + 1 < nchunks;
+
+        pthread_mutex_lock(&p.mu);
+        sl->ready = 0;
+        p.written++;
+        pthread_cond_broadcast(&p.cv);
+        pthread_mutex_unlock(&p.mu);
+        if (rc != 0 || shrank) break; // error, or file shrank under us
+    }
+    if (rc == 0 && started > 0 && k < nchunks && !shrank) {
+        rc = -1;
+    }
+
+    pthread_mutex_lock(&p.mu);
+    p.stop = 1;
+    pthread_cond_broadcast(&p.cv);
+    pthread_mutex_unlock(&p.mu);
+    for (int t = 0; t < started; t++) {
+        pthread_join(tids[t], NULL);
+    }
+
+    if (rc == 0 && started == 0) {
+        rc = 1; // caller falls back
+    } else if (rc == 0 && squeezing) {
+        char tail[32];
+        size_t n = format_tail(tail, sizeof tail, end);
+        if (write_all(STDOUT_FILENO, tail, n) != 0) {
+            perror("write");
+            rc = -1;
+        }
+    }
+
+    free(tids);
+    for (size_t i = 0; i < p.window; i++) free(p.slots[i].text);
+    free(p.slots);
+    pthread_cond_destroy(&p.cv);
+    pthread_mutex_destroy(&p.mu);
+    return rc;
+}
+
+// Dump one range; the offset column shows absolute file offsets.
+// returns: 0 on success (EOF inside the range is fine), -1 on I/O error
+static int dump_range(struct input *in, struct range r, int squeeze, int jobs) {
+    static unsigned char buf[BLOCK_SIZE];
+    static char out[BLOCK_SIZE / LINE_WIDTH * ROW_CHARS];
+    uint64_t offset = r.start;
+    struct squeeze sq = { .enabled = squeeze };
+
+    if (jobs > 1 && in->seekable) {
+        int rc = dump_parallel(in, r, squeeze, jobs);
+        if (rc <= 0) return rc;
+    }
+
+    if (!in->seekable) {
+        if (offset < in->pos) {
+            fprintf(stderr, "Range at 0x%" PRIx64 " is behind the current position of a pipe; "
+                            "ranges on non-seekable input must be in increasing order\n", offset);
+            return -1;
+        }
+        int rc = skip_to(in, buf, offset);
+        if (rc < 0) {
+            perror("read");
+            return -1;
+        }
+        if (rc > 0) return 0; // range starts past EOF: nothing to show
+    }
+
+    struct sink sink = { .fd = STDOUT_FILENO };
+    if (dump_span(in, &sq, &offset, r.len, buf, out, &sink) != 0) return -1;
+
+    // Ended inside a "*" run: say where the data stopped
+    if (sq.squeezing) {
+        char tail[32];
+        size_t n = format_tail(tail, sizeof tail, offset);
+        if (write_all(STDOUT_FILENO, tail, n) != 0) {
+            perror("write");
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// ---- reverse mode (-r) ----
+//
+// Turns a dump back into bytes. Understands, line by line:
+//   Offset 0000000000000010: 48 65 ... |Hel...|   a row (ASCII column ignored)
+//   *                                             repeats of the row above
+//   Offset 0000000000001000                       where a squeezed dump ended
+//   48656c6c6f 0a ...                             plain hex, continues at the
+//                                                 current offset
+// Rows are written at their own offsets, so an edited excerpt (say from
+// hdx -s) can be patched straight back into the original file with -o.
+
+enum { REV_IN_SIZE = 1024 * 1024, REV_OUT_SIZE = 1024 * 1024 };
+
+// hex_val[c] = value of hex digit c, or -1
+static signed char hex_val[256];
+
+static void init_hex_val(void) {
+    memset(hex_val, -1, sizeof hex_val);
+    for (int d = 0; d < 10; d++) hex_val['0' + d] = (signed char)d;
+    for (int d = 0; d < 6; d++) {
+        hex_val['a' + d] = (signed char)(10 + d);
+        hex_val['A' + d] = (signed char)(10 + d);
+    }
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+#define HAVE_SSSE3_DECODE 1
+
+// 32 ASCII hex digits (in d0, d1) -> 16 bytes. Digits become nibbles with
+// range compares, then maddubs folds each hi/lo pair into hi*16 + lo.
+// returns: 1 on success, 0 if any char wasn't a hex digit
+__attribute__((target("ssse3")))
+static int nibbles_to_bytes(__m128i d0, __m128i d1, unsigned char *out) {
+    const __m128i c0 = _mm_set1_epi8('0' - 1), c9 = _mm_set1_epi8('9' + 1);
+    const __m128i ca = _mm_set1_epi8('a' - 1), cf = _mm_set1_epi8('f' + 1);
+    const __m128i lower = _mm_set1_epi8(0x20);
+    const __m128i weights = _mm_set1_epi16(0x0110); // hi digit * 16, lo digit * 1
+    __m128i v[2] = { d0, d1 };
+    int ok = 0xFFFF;
+
+    for (int k = 0; k < 2; k++) {
+        __m128i is_dig = _mm_and_si128(_mm_cmpgt_epi8(v[k], c0), _mm_cmpgt_epi8(c9, v[k]));
+        __m128i l = _mm_or_si128(v[k], lower);
+        __m128i is_alpha = _mm_and_si128(_mm_cmpgt_epi8(l, ca), _mm_cmpgt_epi8(cf, l));
+        ok &= _mm_movemask_epi8(_mm_or_si128(is_dig, is_alpha));
+
+        __m128i dig = _mm_and_si128(is_dig, _mm_sub_epi8(v[k], _mm_set1_epi8('0')));
+        __m128i alpha = _mm_and_si128(is_alpha, _mm_sub_epi8(l, _mm_set1_epi8('a' - 10)));
+        v[k] = _mm_maddubs_epi16(_mm_or_si128(dig, alpha), weights);
+    }
+    if (ok != 0xFFFF) return 0;
+    _mm_storeu_si128((__m128i *)out, _mm_packus_epi16(v[0], v[1]));
+    return 1;
+}
+
+// Plain run of 32 hex digits -> 16 bytes
+__attribute__((target("ssse3")))
+static int decode_hex32_ssse3(const char *p, unsigned char *out) {
+    return nibbles_to_bytes(_mm_loadu_si128((const __m128i *)p),
+                            _mm_loadu_si128((const __m128i *)(p + 16)), out);
+}
+
+// 16 hex digits -> 8 bytes (second half of the vector is padding '0's)
+__attribute__((target("ssse3")))
+static int decode_hex16_ssse3(const char *p, unsigned char *out) {
+    unsigned char tmp[16];
+    if (!nibbles_to_bytes(_mm_loadu_si128((const __m128i *)p), _mm_set1_epi8('0'), tmp)) return 0;
+    memcpy(out, tmp, 8);
+    return 1;
+}
+
+// The 48-char hex column of a full row ("XX XX ... XX ") -> 16 bytes.
+// Byte i's digits sit at 3i and 3i+1; pshufb gathers them out of the
+// three 16-char loads so no spaces reach the converter.
+__attribute__((target("ssse3")))
+static int decode_row48_ssse3(const char *p, unsigned char *out) {
+    __m128i a = _mm_loadu_si128((const __m128i *)p);
+    __m128i b = _mm_loadu_si128((const __m128i *)(p + 16));
+    __m128i c = _mm_loadu_si128((const __m128i *)(p + 32));
+    __m128i d0 = _mm_or_si128(
+        _mm_shuffle_epi8(a, _mm_setr_epi8(0, 1, 3, 4, 6, 7, 9, 10, 12, 13, 15, -1, -1, -1, -1, -1)),
+        _mm_shuffle_epi8(b, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 2, 3, 5, 6)));
+    __m128i d1 = _mm_or_si128(
+        _mm_shuffle_epi8(b, _mm_setr_epi8(8, 9, 11, 12, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1)),
+        _mm_shuffle_epi8(c, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, 1, 2, 4, 5, 7, 8, 10, 11, 13, 14)));
+    return nibbles_to_bytes(d0, d1, out);
+}
+#endif
+
+static int have_ssse3;
+
+// Where decoded bytes go. Contiguous bytes collect in buf and go out with one
+// pwrite (or write, for a pipe) when the run breaks or buf fills up.
+struct rev_out {
+    int fd;
+    int seekable;       // pwrite at any offset; otherwise strictly forward
+    uint64_t size;      // seekable: file size so far (existing data + ours)
+    uint64_t written;   // !seekable: bytes already written to the stream
+    uint64_t base;      // offset of buf[0]
+    unsigned char *buf;
+    size_t len;
+    uint64_t end;       // furthest offset the dump says exists
+};
+
+static int rev_flush(struct rev_out *o) {
+    if (o->len == 0) return 0;
+    const unsigned char *p = o->buf;
+    size_t n = o->len;
+    uint64_t off = o->base;
+    while (n > 0) {
+        ssize_t w = o->seekable ? pwrite(o->fd, p, n, (off_t)off) : write(o->fd, p, n);
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            perror("write");
+            return -1;
+        }
+        p += w;
+        n -= (size_t)w;
+        off += (uint64_t)w;
+    }
+    if (o->seekable) {
+        if (off > o->size) o->size = off;
+    } else {
+        o->written = off;
+    }
+    o->base = off;
+    o->len = 0;
+    return 0;
+}
+
+// Start the buffered run at `offset`. A stream can't seek, so a gap is
+// filled with zeros and going backwards is an error.
+static int rev_seek(struct rev_out *o, uint64_t offset) {
+    if (offset == o->base + o->len) return 0;
+    if (rev_flush(o) != 0) return -1;
+    if (o->seekable) {
+        o->base = offset;
+        return 0;
+    }
+    if (offset < o->written) {
+        fprintf(stderr, "Offset 0x%" PRIx64 " goes backwards; use -o FILE to write out of order\n", offset);
+        return -1;
+    }
+    while (o->written + o->len < offset) {
+        uint64_t gap = offset - (o->written + o->len);
+        size_t room = REV_OUT_SIZE - o->len;
+        size_t n = gap < room ? (size_t)gap : room;
+        memset(o->buf + o->len, 0, n);
+        o->len += n;
+        if (o->len == REV_OUT_SIZE && rev_flush(o) != 0) return -1;
+    }
+    return 0;
+}
+
+static int rev_put(struct rev_out *o, uint64_t offset, const unsigned char *data, size_t n) {
+    if (rev_seek(o, offset) != 0) return -1;
+    if (offset + n > o->end) o->end = offset + n;
+    while (n > 0) {
+        size_t room = REV_OUT_SIZE - o->len;
+        size_t k = n < room ? n : room;
+        memcpy(o->buf + o->len, data, k);
+        o->len += k;
+        data += k;
+        n -= k;
+        if (o->len == REV_OUT_SIZE && rev_flush(o) != 0) return -1;
+    }
+    return 0;
+}
+
+// Expand a "*": `count` copies of row starting at offset. Zero rows past the
+// end of what's in the file are left as a hole (ftruncate extends it later),
+// so sparse images come back sparse.
+static int rev_repeat(struct rev_out *o, uint64_t offset, const unsigned char *row, uint64_t count) {
+    static const unsigned char zeros[LINE_WIDTH];
+    uint64_t stop = offset + count * LINE_WIDTH;
+    if (count == 0) return 0;
+    if (o->seekable && memcmp(row, zeros, LINE_WIDTH) == 0) {
+        if (rev_flush(o) != 0) return -1;
+        if (offset >= o->size) {
+            if (stop > o->end) o->end = stop;
+            return 0;
+        }
+    }
+    for (uint64_t k = 0; k < count; k++) {
+        if (rev_put(o, offset + k * LINE_WIDTH, row, LINE_WIDTH) != 0) return -1;
+    }
+    if (stop > o->end) o->end = stop;
+    return 0;
+}
+
+// Parser state carried from line to line
+struct rev_state {
+    uint64_t next;                  // offset the next plain hex byte goes to
+    unsigned char prev[LINE_WIDTH]; // last full row, for "*"
+    int have_prev;
+    int pending_star;               // saw "*", fill happens at the next offset
+    int half;                       // plain hex: high nibble waiting for its pair
+    unsigned char hi;
+    uint64_t line;                  // for error messages
+};
+
+// Scalar hex pairs from p[0..n), skipping blanks; stops at '|' or n.
+// returns: bytes decoded into out (at most max), or -1 on a bad character
+static ssize_t decode_pairs(const char *p, size_t n, unsigned char *out, size_t max) {
+    size_t got = 0;
+    size_t i = 0;
+    while (i < n && got < max) {
+        unsigned char c = (unsigned char)p[i];
+        if (c == ' ' || c == '\t' || c == '\r') {
+            i++;
+            continue;
+        }
+        if (c == '|') break;
+        if (i + 1 >= n || hex_val[c] < 0 || hex_val[(unsigned char)p[i + 1]] < 0) return -1;
+        out[got++] = (unsigned char)(hex_val[c] << 4 | hex_val[(unsigned char)p[i + 1]]);
+        i += 2;
+    }
+    return (ssize_t)got;
+}
+
+// Parse the 16 hex digits of "Offset XXXXXXXXXXXXXXXX"; line must be >= 23 chars
+static int parse_row_offset(const char *line, uint64_t *off) {
+#ifdef HAVE_SSSE3_DECODE
+    unsigned char be[8];
+    if (have_ssse3 && decode_hex16_ssse3(line + 7, be)) {
+        uint64_t v = 0;
+        for (int k = 0; k < 8; k++) v = v << 8 | be[k];
+        *off = v;
+        return 0;
+    }
+#endif
+    uint64_t v = 0;
+    for (int k = 7; k < 23; k++) {
+        int d = hex_val[(unsigned char)line[k]];
+        if (d < 0) return -1;
+        v = v << 4 | (uint64_t)d;
+    }
+    *off = v;
+    return 0;
+}
+
+// Catch up on a pending "*" before writing at `offset`
+static int rev_settle(struct rev_out *o, struct rev_state *st, uint64_t offset) {
+    if (!st->pending_star) return 0;
+    st->pending_star = 0;
+    if (!st->have_prev || offset < st->next) return 0;
+    return rev_repeat(o, st->next, st->prev, (offset - st->next) / LINE_WIDTH);
+}
+
+static int rev_plain(struct rev_out *o, struct rev_state *st, const char *p, size_t n) {
+    unsigned char tmp[4096];
+    size_t got = 0;
+    size_t i = 0;
+    while (i < n) {
+#ifdef HAVE_SSSE3_DECODE
+        // long runs of unbroken digits (xxd -p style) go 32 at a time
+        while (have_ssse3 && !st->half && i + 32 <= n && got + 16 <= sizeof tmp &&
+               decode_hex32_ssse3(p + i, tmp + got)) {
+            i += 32;
+            got += 16;
+        }
+        if (have_ssse3 && !st->half && i + 16 <= n && got + 16 <= sizeof tmp &&
+            decode_hex16_ssse3(p + i, tmp + got)) {
+            i += 16;
+            got += 8;
+            continue;
+        }
+#endif
+        if (i >= n) break;
+
+        // anything else a digit at a time; a pair may straddle blanks
+        unsigned char c = (unsigned char)p[i++];
+        if (c == ' ' || c == '\t' || c == '\r' || c == '\n') continue;
+        if (hex_val[c] < 0) {
+            fprintf(stderr, "line %" PRIu64 ": not a hex digit: '%c'\n", st->line, c);
+            return -1;
+        }
+        if (!st->half) {
+            st->hi = (unsigned char)hex_val[c];
+            st->half = 1;
+            continue;
+        }
+        st->half = 0;
+        tmp[got++] = (unsigned char)(st->hi << 4 | hex_val[c]);
+
+        if (got + 16 > sizeof tmp) {
+            if (rev_put(o, st->next, tmp, got) != 0) return -1;
+            st->next += got;
+            got = 0;
+        }
+    }
+    if (got > 0) {
+        if (rev_put(o, st->next, tmp, got) != 0) return -1;
+        st->next += got;
+    }
+    return 0;
+}
+
+// One line without its '\n'
+static int rev_line(struct rev_out *o, struct rev_state *st, const char *line, size_t n) {
+    st->line++;
+    if (n > 0 && line[n - 1] == '\r') n--;
+
+    if (n >= 23 && memcmp(line, "Offset ", 7) == 0) {
+        uint64_t off;
+        if (parse_row_offset(line, &off) != 0) {
+            fprintf(stderr, "line %" PRIu64 ": bad offset\n", st->line);
+            return -1;
+        }
+        if (n == 23) {
+            // closing line of a squeezed dump
+            if (rev_settle(o, st, off) != 0) return -1;
+            if (off > o->end) o->end = off;
+            st->next = off;
+            return 0;
+        }
+        if (n < 25 || line[23] != ':') {
+            fprintf(stderr, "line %" PRIu64 ": expected ':' after the offset\n", st->line);
+            return -1;
+        }
+        if (rev_settle(o, st, off) != 0) return -1;
+
+        unsigned char row[LINE_WIDTH];
+        ssize_t got = -1;
+#ifdef HAVE_SSSE3_DECODE
+        // untouched full row: hex column is exactly 48 chars followed by " |"
+        if (have_ssse3 && n >= 25 + 50 && line[25 + 48] == ' ' && line[25 + 49] == '|' &&
+            decode_row48_ssse3(line + 25, row)) {
+            got = LINE_WIDTH;
+        }
+#endif
+        if (got < 0) got = decode_pairs(line + 24, n - 24, row, LINE_WIDTH);
+        if (got < 0) {
+            fprintf(stderr, "line %" PRIu64 ": bad hex byte\n", st->line);
+            return -1;
+        }
+        if (rev_put(o, off, row, (size_t)got) != 0) return -1;
+        st->next = off + (uint64_t)got;
+        st->have_prev = got == LINE_WIDTH;
+        if (st->have_prev) memcpy(st->prev, row, LINE_WIDTH);
+        st->half = 0;
+        return 0;
+    }
+
+    if (n == 1 && line[0] == '*') {
+        st->pending_star = 1;
+        return 0;
+    }
+    return rev_plain(o, st, line, n);
+}
+
+// Hand every complete line in p[0..have) to rev_line.
+// returns: bytes consumed (up to the last '\n'), or -1 on error
+static ssize_t rev_lines(struct rev_out *o, struct rev_state *st, const char *p, size_t have) {
+    size_t start = 0;
+    for (;;) {
+        const char *nl = memchr(p + start, '\n', have - start);
+        if (!nl) break;
+        size_t len = (size_t)(nl - (p + start));
+        if (rev_line(o, st, p + start, len) != 0) return -1;
+        start += len + 1;
+    }
+    return (ssize_t)start;
+}
+
+// Feed the whole input through the line parser and finish the output file.
+// Regular files are mapped and parsed in place; anything else is read in
+// REV_IN_SIZE pieces with the partial last line carried over.
+// returns: 0 on success, -1 on error (already reported)
+static int reverse_dump(int in_fd, int out_fd) {
+    struct rev_out o = { .fd = out_fd };
+    struct rev_state st = { 0 };
+    struct stat sb;
+    if (fstat(out_fd, &sb) == 0 && S_ISREG(sb.st_mode)) {
+        o.seekable = 1;
+        o.size = (uint64_t)sb.st_size;
+    }
+    init_hex_val();
+#ifdef HAVE_SSSE3_DECODE
+    have_ssse3 = __builtin_cpu_supports("ssse3");
+#endif
+
+    o.buf = malloc(REV_OUT_SIZE);
+    if (!o.buf) {
+        perror("malloc");
+        return -1;
+    }
+
+    int rc = 0;
+    char *map = MAP_FAILED;
+    size_t map_len = 0;
+    if (fstat(in_fd, &sb) == 0 && S_ISREG(sb.st_mode) && sb.st_size > 0) {
+        map_len = (size_t)sb.st_size;
+        map = mmap(NULL, map_len, PROT_READ, MAP_PRIVATE, in_fd, 0);
+        if (map != MAP_FAILED) madvise(map, map_len, MADV_SEQUENTIAL);
+    }
+
+    if (map != MAP_FAILED) {
+        ssize_t used = rev_lines(&o, &st, map, map_len);
+        if (used < 0) {
+            rc = -1;
+        } else if ((size_t)used < map_len) {
+            rc = rev_line(&o, &st, map + used, map_len - (size_t)used); // no final '\n'
+        }
+        munmap(map, map_len);
+    } else {
+        char *in = malloc(REV_IN_SIZE);
+        if (!in) {
+            perror("malloc");
+            free(o.buf);
+            return -1;
+        }
+        size_t have = 0;
+        for (;;) {
+            ssize_t r = read(in_fd, in + have, REV_IN_SIZE - have);
+            if (r < 0) {
+                if (errno == EINTR) continue;
+                perror("read");
+                rc = -1;
+                break;
+            }
+            have += (size_t)r;
+
+            ssize_t used = rev_lines(&o, &st, in, have);
+            if (used < 0) {
+                rc = -1;
+                break;
+            }
+            size_t start = (size_t)used;
+
+            if (have > start && r == 0) {
+                rc = rev_line(&o, &st, in + start, have - start); // no final '\n'
+                start = have;
+            } else if (start == 0 && have == REV_IN_SIZE) {
+                // a line longer than the buffer: only plain hex gets that
+                // long, so decode it in pieces (a dangling half byte carries
+                // over in st.half)
+                rc = rev_plain(&o, &st, in, have);
+                start = have;
+            }
+            if (rc != 0) break;
+            memmove(in, in + start, have - start);
+            have -= start;
+            if (r == 0) break;
+        }
+        free(in);
+    }
+
+    if (rc == 0 && st.half) {
+        fprintf(stderr, "warning: odd number of hex digits, last nibble dropped\n");
+    }
+    if (rc == 0) rc = rev_flush(&o);
+    // a squeezed dump can end in zeros we never wrote; make the file that long
+    if (rc == 0 && o.end > (o.seekable ? o.size : o.written)) {
+        if (o.seekable) {
+            if (ftruncate(o.fd, (off_t)o.end) != 0) {
+                perror("ftruncate");
+                rc = -1;
+            }
+        } else {
+            rc = rev_seek(&o, o.end);
+            if (rc == 0) rc = rev_flush(&o);
+        }
+    }
+
+    free(o.buf);
+    return rc;
+}
+
+// ---- diff mode (--diff A B) ----
+//
+// Walks both files in step and prints only the rows that differ, A's
+// version on the left and B's on the right:
+//   Offset 0000000000000010: 48 65 6C ... |Hel...|  48 65 6D ... |Hem...|
+// Whole DIFF_BLOCK stretches are compared with one memcmp first, so long
+// identical regions (most of a firmware image) cost about a memory scan.
+// On a terminal the differing bytes are shown in red.
+
+enum { DIFF_BLOCK = 1024 * 1024, DIFF_OUT_SIZE = 64 * 1024 };
+
+static const char diff_on[] = "\033[1;31m";
+static const char diff_off[] = "\033[0m";
+
+// One side of the diff: mmapped when it's a regular file, otherwise read
+// front to back (pipes, devices) through buf.
+struct diff_src {
+    int fd;
+    const unsigned char *map;   // NULL when streaming (or the file is empty)
+    uint64_t size;              // mapped: file size
+    int streaming;
+    int eof;                    // streaming: input ran out
+    unsigned char *buf;         // streaming: DIFF_BLOCK bytes
+};
+
+static int diff_open(struct diff_src *src, const char *path) {
+    struct stat st;
+    memset(src, 0, sizeof *src);
+    src->fd = open(path, O_RDONLY);
+    if (src->fd < 0 || fstat(src->fd, &st) != 0) {
+        perror(path);
+        return -1;
+    }
+    if (S_ISREG(st.st_mode)) {
+        src->size = (uint64_t)st.st_size;
+        if (src->size == 0) return 0;
+        void *m = mmap(NULL, (size_t)src->size, PROT_READ, MAP_PRIVATE, src->fd, 0);
+        if (m != MAP_FAILED) {
+            madvise(m, (size_t)src->size, MADV_SEQUENTIAL);
+            src->map = m;
+            return 0;
+        }
+    }
+    src->streaming = 1;
+    src->buf = malloc(DIFF_BLOCK);
+    if (!src->buf) {
+        perror("malloc");
+        return -1;
+    }
+    return 0;
+}
+
+static void diff_close(struct diff_src *src) {
+    if (src->map) munmap((void *)src->map, (size_t)src->size);
+    free(src->buf);
+    if (src->fd >= 0) close(src->fd);
+}
+
+// Point *p at up to want bytes starting at offset (calls come in order).
+// returns: bytes available (short only at EOF), or -1 on a read error
+static ssize_t diff_fetch(struct diff_src *src, uint64_t offset, size_t want, const unsigned char **p) {
+    if (!src->streaming) {
+        if (offset >= src->size) return 0;
+        uint64_t left = src->size - offset;
+        *p = src->map + offset;
+        return (ssize_t)(left < want ? left : want);
+    }
+    if (src->eof) return 0;
+    struct input in = { .fd = src->fd };
+    ssize_t got = read_full(&in, src->buf, want, offset);
+    if (got < 0) {
+        perror("read");
+        return -1;
+    }
+    if ((size_t)got < want) src->eof = 1;
+    *p = src->buf;
+    return got;
+}
+
+// Pipes can't seek: read and drop everything before the start offset
+static int diff_skip(struct diff_src *src, uint64_t offset) {
+    if (!src->streaming) return 0;
+    struct input in = { .fd = src->fd };
+    if (skip_to(&in, src->buf, offset) < 0) {
+        perror("read");
+        return -1;
+    }
+    return 0;
+}
+
+// Hex + ASCII columns for one side, highlighting bytes that don't match
+// the other side (or that the other side doesn't have at all)
+static char *diff_side(char *p, const unsigned char *mine, size_t n,
+                       const unsigned char *theirs, size_t tn, int color) {
+    for (size_t i = 0; i < LINE_WIDTH; i++) {
+        if (i >= n) {
+            memcpy(p, "   ", 3);
+            p += 3;
+            continue;
+        }
+        int hot = color && (i >= tn || mine[i] != theirs[i]);
+        if (hot) { memcpy(p, diff_on, sizeof diff_on - 1); p += sizeof diff_on - 1; }
+        memcpy(p, hex_pair[mine[i]], 2);
+        p += 2;
+        if (hot) { memcpy(p, diff_off, sizeof diff_off - 1); p += sizeof diff_off - 1; }
+        *p++ = ' ';
+    }
+    *p++ = ' ';
+    *p++ = '|';
+    for (size_t i = 0; i < LINE_WIDTH; i++) {
+        if (i >= n) {
+            *p++ = ' ';
+            continue;
+        }
+        int hot = color && (i >= tn || mine[i] != theirs[i]);
+        if (hot) { memcpy(p, diff_on, sizeof diff_on - 1); p += sizeof diff_on - 1; }
+        *p++ = ascii_char[mine[i]];
+        if (hot) { memcpy(p, diff_off, sizeof diff_off - 1); p += sizeof diff_off - 1; }
+    }
+    *p++ = '|';
+    return p;
+}
+
+// Worst case for one side: every byte wrapped in color codes twice
+enum { DIFF_ROW_MAX = 32 + 2 * (LINE_WIDTH * (3 + 1 + 2 * (sizeof diff_on + sizeof diff_off)) + 8) };
+
+static size_t format_diff_row(char *dst, uint64_t offset, const unsigned char *a, size_t an,
+                              const unsigned char *b, size_t bn, int color) {
+    char *p = dst;
+    memcpy(p, "Offset ", 7);
+    p += 7;
+    for (int shift = 60; shift >= 0; shift -= 4) {
+        *p++ = "0123456789abcdef"[(offset >> shift) & 0xF];
+    }
+    *p++ = ':';
+    *p++ = ' ';
+    p = diff_side(p, a, an, b, bn, color);
+    *p++ = ' ';
+    *p++ = ' ';
+    p = diff_side(p, b, bn, a, an, color);
+    *p++ = '\n';
+    return (size_t)(p - dst);
+}
+
+// returns: 0 if the ranges are identical, 1 if they differ, -1 on error
+static int diff_files(const char *path_a, const char *path_b, uint64_t start, uint64_t limit) {
+    struct diff_src a = { .fd = -1 }, b = { .fd = -1 };
+    int rc = -1;
+    if (diff_open(&a, path_a) != 0 || diff_open(&b, path_b) != 0) goto out;
+    if (diff_skip(&a, start) != 0 || diff_skip(&b, start) != 0) goto out;
+
+    int color = isatty(STDOUT_FILENO);
+    static char out[DIFF_OUT_SIZE];
+    size_t used = 0;
+    int differ = 0;
+    uint64_t offset = start;
+
+    for (;;) {
+        if (limit == 0) break;
+        size_t want = DIFF_BLOCK;
+        if (limit != UINT64_MAX && limit < want) want = (size_t)limit;
+
+        const unsigned char *pa = NULL, *pb = NULL;
+        ssize_t la = diff_fetch(&a, offset, want, &pa);
+        ssize_t lb = diff_fetch(&b, offset, want, &pb);
+        if (la < 0 || lb < 0) goto out;
+        size_t most = (size_t)(la > lb ? la : lb);
+        if (most == 0) break;
+
+        // the fast path: the whole block matches
+        if (la == lb && memcmp(pa, pb, (size_t)la) == 0) {
+            offset += most;
+            if (limit != UINT64_MAX) limit -= most;
+            if (most < want) break;
+            continue;
+        }
+
+        for (size_t i = 0; i < most; i += LINE_WIDTH) {
+            size_t an = (size_t)la > i ? (size_t)la - i : 0;
+            size_t bn = (size_t)lb > i ? (size_t)lb - i : 0;
+            if (an > LINE_WIDTH) an = LINE_WIDTH;
+            if (bn > LINE_WIDTH) bn = LINE_WIDTH;
+            if (an == bn && (an == LINE_WIDTH ? rows_equal(pa + i, pb + i)
+                                              : memcmp(pa + i, pb + i, an) == 0)) {
+                continue;
+            }
+            differ = 1;
+            if (used + DIFF_ROW_MAX > sizeof out) {
+                if (write_all(STDOUT_FILENO, out, used) != 0) {
+                    perror("write");
+                    goto out;
+                }
+                used = 0;
+            }
+            used += format_diff_row(out + used, offset + i, an ? pa + i : NULL, an,
+                                    bn ? pb + i : NULL, bn, color);
         }
+
+        offset += most;
+        if (limit != UINT64_MAX) limit -= most;
+        if (most < want) break;
+    }
+
+    if (used > 0 && write_all(STDOUT_FILENO, out, used) != 0) {
+        perror("write");
+        goto out;
     }
+    rc = differ;
+out:
+    diff_close(&a);
+    diff_close(&b);
+    return rc;
+}
+
+// ---- search mode (--find PATTERN) ----
+//
+// PATTERN is hex bytes, spaces optional, "??" matching any byte:
+//   hdx disk.img --find "89 50 4E 47 ?? ?? ?? ?? 49 48 44 52"
+// Every match offset is printed, optionally with -C rows of dump around it.
+// The input streams through a window; the tail of each window (pattern
+// length - 1, plus context) carries into the next, so matches and their
+// context may straddle reads.
+
+enum { FIND_MAX = 256, FIND_BLOCK = 1024 * 1024 };
+
+struct pattern {
+    unsigned char byte[FIND_MAX];
+    unsigned char any[FIND_MAX];    // 1 = wildcard
+    size_t len;
+    size_t shift[256];              // Horspool bad-character table
+    size_t rare;                    // index of the concrete byte memchr hunts for
+};
+
+// Rough "how common is this byte in binaries" rank (higher = more common);
+// the prefilter looks for the pattern byte that scores lowest.
+static int byte_rank(unsigned char c) {
+    if (c == 0x00 || c == 0xFF) return 100;
+    if (c == ' ' || c == 'e' || c == 't' || c == 'a' || c == 'o') return 80;
+    if (c >= 'a' && c <= 'z') return 60;
+    if (c < 0x10) return 50;           // small ints, lengths, flags
+    if (c >= 0x20 && c < 0x7F) return 40;
+    return 10;
+}
+
+static int parse_pattern(const char *str, struct pattern *pat) {
+    memset(pat, 0, sizeof *pat);
+    init_hex_val();
+    const char *p = str;
+    while (*p) {
+        if (*p == ' ' || *p == '\t') {
+            p++;
+            continue;
+        }
+        if (pat->len == FIND_MAX) {
+            fprintf(stderr, "--find pattern longer than %d bytes\n", FIND_MAX);
+            return -1;
+        }
+        if (p[0] == '?' && p[1] == '?') {
+            pat->any[pat->len++] = 1;
+        } else if (p[1] && hex_val[(unsigned char)p[0]] >= 0 && hex_val[(unsigned char)p[1]] >= 0) {
+            pat->byte[pat->len++] = (unsigned char)(hex_val[(unsigned char)p[0]] << 4 |
+                                                    hex_val[(unsigned char)p[1]]);
+        } else {
+            fprintf(stderr, "Invalid --find pattern at '%s' (want hex pairs or ?\?)\n", p);
+            return -1;
+        }
+        p += 2;
+    }
+
+    int best = -1;
+    for (size_t i = 0; i < pat->len; i++) {
+        if (pat->any[i]) continue;
+        if (best < 0 || byte_rank(pat->byte[i]) < byte_rank(pat->byte[pat->rare])) {
+            pat->rare = i;
+            best = 1;
+        }
+    }
+    if (best < 0) {
+        fprintf(stderr, "--find pattern needs at least one byte that isn't ??\n");
+        return -1;
+    }
+
+    // Horspool: how far the window may slide when its last byte is c. A
+    // wildcard matches anything, so nothing may slide past the last one.
+    size_t m = pat->len;
+    size_t dflt = m;
+    for (size_t i = 0; i + 1 < m; i++) {
+        if (pat->any[i]) dflt = m - 1 - i;
+    }
+    for (int c = 0; c < 256; c++) pat->shift[c] = dflt;
+    for (size_t i = 0; i + 1 < m; i++) {
+        if (!pat->any[i] && m - 1 - i < pat->shift[pat->byte[i]]) {
+            pat->shift[pat->byte[i]] = m - 1 - i;
+        }
+    }
+    return 0;
+}
+
+static int pattern_at(const struct pattern *pat, const unsigned char *p) {
+    for (size_t i = 0; i < pat->len; i++) {
+        if (!pat->any[i] && p[i] != pat->byte[i]) return 0;
+    }
+    return 1;
+}
+
+// First match whose start lies in [from, to), with the pattern fully inside
+// buf[0..n). Starts on the memchr prefilter (fast when the rare byte is rare)
+// and drops to Horspool once candidates come too thick to pay off.
+// returns: match index, or SIZE_MAX
+static size_t find_next(const struct pattern *pat, const unsigned char *buf, size_t n,
+                        size_t from, size_t to, int *use_horspool) {
+    size_t m = pat->len;
+    if (to > n - m + 1) to = n - m + 1;
+    if (from >= to) return SIZE_MAX;
+
+    if (!*use_horspool) {
+        size_t r = pat->rare;
+        size_t pos = from;
+        size_t misses = 0;
+        while (pos < to) {
+            const unsigned char *hit = memchr(buf + pos + r, pat->byte[r], to - pos);
+            if (!hit) return SIZE_MAX;
+            size_t s = (size_t)(hit - buf) - r;
+            if (pattern_at(pat, buf + s)) return s;
+            pos = s + 1;
+            // a false hit every few bytes: memchr keeps stopping, switch over
+            if (++misses > 64 && (pos - from) / misses < 32) {
+                *use_horspool = 1;
+                from = pos;
+                break;
+            }
+        }
+        if (!*use_horspool) return SIZE_MAX;
+    }
+
+    size_t s = from;
+    while (s < to) {
+        unsigned char last = buf[s + m - 1];
+        if ((pat->any[m - 1] || last == pat->byte[m - 1]) && pattern_at(pat, buf + s)) return s;
+        s += pat->shift[last];
+    }
+    return SIZE_MAX;
+}
+
+// Print one match: the offset line, then (with -C) the rows around it
+static int report_match(const struct pattern *pat, uint64_t at, const unsigned char *buf,
+                        uint64_t base, size_t have, uint64_t lo, size_t ctx_rows) {
+    char line[64];
+    int n = snprintf(line, sizeof line, "Match at Offset %016" PRIx64 "\n", at);
+    if (write_all(STDOUT_FILENO, line, (size_t)n) != 0) return -1;
+    if (ctx_rows == 0) return 0;
+
+    // whole rows on the absolute 16-byte grid, clipped to what's buffered
+    // (and to the search range)
+    uint64_t from = (at / LINE_WIDTH) * LINE_WIDTH;
+    uint64_t back = (uint64_t)ctx_rows * LINE_WIDTH;
+    from = from > back ? from - back : 0;
+    if (from < lo) from = lo;
+    if (from < base) from = base;
+    uint64_t to = ((at + pat->len + LINE_WIDTH - 1) / LINE_WIDTH + ctx_rows) * LINE_WIDTH;
+    if (to > base + have) to = base + have;
+
+    static char out[(FIND_MAX / LINE_WIDTH + 2 + 2 * 64) * ROW_CHARS + 4];
+    struct squeeze sq = { .enabled = 0 };
+    size_t len = format_block(&sq, out, from, buf + (from - base), (size_t)(to - from));
+    memcpy(out + len, "--\n", 3);
+    return write_all(STDOUT_FILENO, out, len + 3);
+}
+
+// returns: 1 if anything matched, 0 if not, -1 on error
+static int find_pattern(struct input *in, const struct pattern *pat, struct range r, size_t ctx_rows) {
+    size_t m = pat->len;
+    size_t ahead = m - 1 + ctx_rows * LINE_WIDTH + LINE_WIDTH; // after a match start
+    size_t behind = ctx_rows * LINE_WIDTH + LINE_WIDTH;        // before it
+    size_t cap = FIND_BLOCK + ahead + behind;
+    unsigned char *buf = malloc(cap);
+    if (!buf) {
+        perror("malloc");
+        return -1;
+    }
+
+    int rc = 0, found = 0, horspool = 0;
+    uint64_t base = r.start;    // absolute offset of buf[0]
+    size_t have = 0;            // bytes in buf
+    size_t scan = 0;            // next match start to try
+    uint64_t limit = r.len;
+    int eof = 0;
+
+    if (!in->seekable) {
+        if (r.start < in->pos) {
+            fprintf(stderr, "--find range is behind the current position of a pipe\n");
+            free(buf);
+            return -1;
+        }
+        int s = skip_to(in, buf, r.start);
+        if (s < 0) {
+            perror("read");
+            free(buf);
+            return -1;
+        }
+        eof = s > 0;
+    }
+
+    while (!eof || scan < have) {
+        // top up the window
+        if (!eof) {
+            horspool = 0; // new data, give the prefilter another chance
+            size_t want = cap - have;
+            if (limit != UINT64_MAX && limit < want) want = (size_t)limit;
+            ssize_t got = read_full(in, buf + have, want, base + have);
+            if (got < 0) {
+                perror("read");
+                rc = -1;
+                break;
+            }
+            have += (size_t)got;
+            if (limit != UINT64_MAX) limit -= (uint64_t)got;
+            if ((size_t)got < want || limit == 0) eof = 1;
+        }
+
+        // Starts we can settle now: everything, at EOF; otherwise only those
+        // whose match and trailing context are already in the window
+        size_t settle = eof ? have : (have > ahead ? have - ahead : 0);
+        for (;;) {
+            size_t s = have >= m ? find_next(pat, buf, have, scan, settle, &horspool) : SIZE_MAX;
+            if (s == SIZE_MAX) break;
+            found = 1;
+            if (report_match(pat, base + s, buf, base, have, r.start, ctx_rows) != 0) {
+                perror("write");
+                rc = -1;
+                break;
+            }
+            scan = s + 1; // overlapping matches count too
+        }
+        if (rc != 0) break;
+        if (scan < settle) scan = settle;
+        if (eof) break;
+
+        // slide: keep `behind` bytes of history before the next start
+        size_t keep_from = scan > behind ? scan - behind : 0;
+        memmove(buf, buf + keep_from, have - keep_from);
+        have -= keep_from;
+        scan -= keep_from;
+        base += keep_from;
+    }
+
+    free(buf);
+    return rc < 0 ? -1 : found;
 }
 
 static void usage(const char *prog) {
-    fprintf(stderr, "Usage: %s [path] [-n BYTES]\n", prog);
-    fprintf(stderr, "  path      optional file path (stdin if omitted)\n");
-    fprintf(stderr, "  -n BYTES  limit output to BYTES read (decimal)\n");
+    fprintf(stderr, "Usage: %s [path] [-v] [-j N] [-s OFFSET] [-n BYTES] [--range START:LEN]...\n", prog);
+    fprintf(stderr, "  path                optional file path (stdin if omitted)\n");
+    fprintf(stderr, "  -s OFFSET           start dumping at OFFSET\n");
+    fprintf(stderr, "  -n BYTES            limit output to BYTES read\n");
+    fprintf(stderr, "  --range START:LEN   dump LEN bytes at START (LEN empty = to EOF); repeatable\n");
+    fprintf(stderr, "  -j N                format with N threads (seekable input only)\n");
+    fprintf(stderr, "  -v                  show every row (don't squeeze repeats into '*')\n");
+    fprintf(stderr, "  OFFSET/BYTES/START/LEN are decimal or 0x hex, with optional K/M/G suffix\n");
+    fprintf(stderr, "       %s [path] -r [-o OUT]\n", prog);
+    fprintf(stderr, "       %s --diff A B [-s OFFSET] [-n BYTES]\n", prog);
+    fprintf(stderr, "       %s [path] --find PATTERN [-C ROWS] [-s OFFSET] [-n BYTES]\n", prog);
+    fprintf(stderr, "  -r                  reverse: turn a dump (or plain hex) back into bytes\n");
+    fprintf(stderr, "  -o OUT              write to OUT at the dump's offsets, without truncating\n");
+    fprintf(stderr, "                      (default stdout; a pipe needs rows in increasing order)\n");
+    fprintf(stderr, "  --diff A B          show only the rows where A and B differ, side by side\n");
+    fprintf(stderr, "                      (exit 0 = same, 1 = different, 2 = trouble)\n");
+    fprintf(stderr, "  --find PATTERN      print the offset of every match of PATTERN, hex bytes\n");
+    fprintf(stderr, "                      with ?? for any byte, e.g. \"89 50 4E 47 ?? ??\"\n");
+    fprintf(stderr, "                      (exit 0 = found, 1 = not found, 2 = trouble)\n");
+    fprintf(stderr, "  -C ROWS             with --find, also dump ROWS rows around each match\n");
 }
 
 int main(int argc, char **argv) {
     const char *path = NULL;
     uint64_t limit = UINT64_MAX;
+    uint64_t skip = 0;
+    int have_skip = 0;
+    int squeeze = 1;
+    int jobs = 1;
+    int reverse = 0;
+    const char *out_path = NULL;
+    const char *diff_a = NULL, *diff_b = NULL;
+    const char *find = NULL;
+    uint64_t ctx_rows = 0;
+    struct range *ranges = NULL;
+    size_t nranges = 0;
 
     // Simple argv scan: [path] is optional and must not start with '-'
-    // Optional: "-n <num>"
+    // Optional: "-n <num>", "-s <offset>", "--range <start:len>" (any number), "-v", "-j <threads>",
+    //           "-r", "-o <out>", "--diff <a> <b>",
+    //           "--find <pattern>", "-C <rows>"
     int i = 1;
     if (i < argc && argv[i][0] != '-') {
         path = argv[i++];
@@ -117,7 +1625,79 @@ int main(int argc, char **argv) {
                 usage(argv[0]); 
                 exit(EXIT_FAILURE); 
             }
-            limit = parse_bytes(argv[i+1]);
+            limit = parse_offset(argv[i+1], "-n");
+            i += 2;
+        } else if (strcmp(argv[i], "-j") == 0) {
+            if (i + 1 >= argc) {
+                usage(argv[0]);
+                exit(EXIT_FAILURE);
+            }
+            uint64_t j = parse_count(argv[i+1], "-j");
+            if (j < 1 || j > 256) {
+                fprintf(stderr, "-j must be between 1 and 256\n");
+                exit(EXIT_FAILURE);
+            }
+            jobs = (int)j;
+            i += 2;
+        } else if (strcmp(argv[i], "--diff") == 0) {
+            if (i + 2 >= argc) {
+                usage(argv[0]);
+                exit(EXIT_FAILURE);
+            }
+            diff_a = argv[i+1];
+            diff_b = argv[i+2];
+            i += 3;
+        } else if (strcmp(argv[i], "--find") == 0) {
+            if (i + 1 >= argc) {
+                usage(argv[0]);
+                exit(EXIT_FAILURE);
+            }
+            find = argv[i+1];
+            i += 2;
+        } else if (strcmp(argv[i], "-C") == 0) {
+            if (i + 1 >= argc) {
+                usage(argv[0]);
+                exit(EXIT_FAILURE);
+            }
+            ctx_rows = parse_count(argv[i+1], "-C");
+            if (ctx_rows > 64) {
+                fprintf(stderr, "-C is limited to 64 rows\n");
+                exit(EXIT_FAILURE);
+            }
+            i += 2;
+        } else if (strcmp(argv[i], "-r") == 0) {
+            reverse = 1;
+            i++;
+        } else if (strcmp(argv[i], "-o") == 0) {
+            if (i + 1 >= argc) {
+                usage(argv[0]);
+                exit(EXIT_FAILURE);
+            }
+            out_path = argv[i+1];
+            i += 2;
+        } else if (strcmp(argv[i], "-v") == 0) {
+            squeeze = 0;
+            i++;
+        } else if (strcmp(argv[i], "-s") == 0) {
+            if (i + 1 >= argc) {
+                usage(argv[0]);
+                exit(EXIT_FAILURE);
+            }
+            skip = parse_offset(argv[i+1], "-s");
+            have_skip = 1;
+            i += 2;
+        } else if (strcmp(argv[i], "--range") == 0) {
+            if (i + 1 >= argc) {
+                usage(argv[0]);
+                exit(EXIT_FAILURE);
+            }
+            struct range *grown = realloc(ranges, (nranges + 1) * sizeof *ranges);
+            if (!grown) {
+                perror("realloc");
+                exit(EXIT_FAILURE);
+            }
+            ranges = grown;
+            ranges[nranges++] = parse_range(argv[i+1]);
             i += 2;
         } else if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
             usage(argv[0]); return 0;
@@ -127,8 +1707,86 @@ int main(int argc, char **argv) {
         }
     }
 
+    if (nranges > 0 && (have_skip || limit != UINT64_MAX)) {
+        fprintf(stderr, "--range can't be combined with -s/-n\n");
+        usage(argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    if (diff_a) {
+        if (path || reverse || out_path || nranges > 0) {
+            fprintf(stderr, "--diff takes two files and only -s/-n\n");
+            exit(2);
+        }
+        init_tables();
+        int rc = diff_files(diff_a, diff_b, skip, limit);
+        return rc < 0 ? 2 : rc;
+    }
+
+    if (find) {
+        if (reverse || out_path || nranges > 0) {
+            fprintf(stderr, "--find takes only -C/-s/-n\n");
+            exit(2);
+        }
+        struct pattern *pat = malloc(sizeof *pat);
+        if (!pat || parse_pattern(find, pat) != 0) exit(2);
+        init_tables();
+        FILE *fp = open_stream(path);
+        struct input in;
+        input_init(&in, fp);
+        struct range whole = { skip, limit };
+        int rc = find_pattern(&in, pat, whole, (size_t)ctx_rows);
+        free(pat);
+        if (fp != stdin) fclose(fp);
+        return rc < 0 ? 2 : !rc;
+    }
+
+    if (reverse) {
+        if (have_skip || limit != UINT64_MAX || nranges > 0) {
+            fprintf(stderr, "-r takes no -s/-n/--range (offsets come from the dump)\n");
+            exit(EXIT_FAILURE);
+        }
+        int out_fd = STDOUT_FILENO;
+        if (out_path) {
+            // no O_TRUNC: -r patches the rows it's given into an existing file
+            out_fd = open(out_path, O_WRONLY | O_CREAT, 0644);
+            if (out_fd < 0) {
+                perror("open");
+                exit(EXIT_FAILURE);
+            }
+        }
+        FILE *fp = open_stream(path);
+        int rc = reverse_dump(fileno(fp), out_fd);
+        if (fp != stdin) fclose(fp);
+        if (out_fd != STDOUT_FILENO && close(out_fd) != 0) {
+            perror("close");
+            rc = -1;
+        }
+        return rc == 0 ? 0 : EXIT_FAILURE;
+    } else if (out_path) {
+        fprintf(stderr, "-o only goes with -r\n");
+        exit(EXIT_FAILURE);
+    }
+
+    init_tables();
     FILE *fp = open_stream(path);
-    read_and_dump(fp, limit);
+    struct input in;
+    input_init(&in, fp);
+
+    int status = 0;
+    if (nranges == 0) {
+        // plain dump is just one range: [-s, -s + -n)
+        struct range whole = { skip, limit };
+        if (dump_range(&in, whole, squeeze, jobs) != 0) status = EXIT_FAILURE;
+    }
+    for (size_t r = 0; r < nranges; r++) {
+        if (dump_range(&in, ranges[r], squeeze, jobs) != 0) {
+            status = EXIT_FAILURE;
+            break;
+        }
+    }
+
+    free(ranges);
     if (fp != stdin) fclose(fp);
-    return 0;
+    return status;
 }
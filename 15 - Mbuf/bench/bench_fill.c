@@ -0,0 +1,146 @@
+// bench_fill.c - how fast can we fill an Mbuf from a file?
+//
+// Build (from "15 - Mbuf"):
+//   gcc -std=c17 -O2 -Wall -Wextra -Iinclude bench/bench_fill.c src/mbuf.c -o bench_fill
+// Run:
+//   ./bench_fill [file]     (no file = make a 256 MiB temp file)
+//
+// Three ways to get the same bytes into the buffer:
+//   1. push_byte  - read(2) into a stack buffer, then mbuf_push_byte per byte (the old way)
+//   2. append     - read(2) into a stack buffer, then one mbuf_append per chunk
+//   3. read_fd    - mbuf_read_fd reads straight into the spare tail, no bounce buffer
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "mbuf.h"
+
+enum { CHUNK = 64 * 1024 };
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+// Write size bytes of junk to a temp file and return its path.
+static const char *make_temp_file(size_t size) {
+    static char path[] = "/tmp/bench_fill_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        perror("mkstemp");
+        exit(1);
+    }
+    unsigned char chunk[CHUNK];
+    for (size_t i = 0; i < sizeof(chunk); i++) {
+        chunk[i] = (unsigned char)(i * 31 + 7);
+    }
+    size_t left = size;
+    while (left > 0) {
+        size_t n = left < sizeof(chunk) ? left : sizeof(chunk);
+        if (write(fd, chunk, n) != (ssize_t)n) {
+            perror("write");
+            exit(1);
+        }
+        left -= n;
+    }
+    close(fd);
+    return path;
+}
+
+static int open_or_die(const char *path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "open %s: %s\n", path, strerror(errno));
+        exit(1);
+    }
+    return fd;
+}
+
+static size_t fill_push_byte(const char *path) {
+    int fd = open_or_die(path);
+    unsigned char chunk[CHUNK];
+    Mbuf b;
+    mbuf_init(&b);
+    ssize_t n;
+    while ((n = read(fd, chunk, sizeof(chunk))) > 0) {
+        for (ssize_t i = 0; i < n; i++) {
+            if (mbuf_push_byte(&b, chunk[i]) != 0) {
+                perror("mbuf_push_byte");
+                exit(1);
+            }
+        }
+    }
+    close(fd);
+    size_t total = b.length;
+    mbuf_free(&b);
+    return total;
+}
+
+static size_t fill_append(const char *path) {
+    int fd = open_or_die(path);
+    unsigned char chunk[CHUNK];
+    Mbuf b;
+    mbuf_init(&b);
+    ssize_t n;
+    while ((n = read(fd, chunk, sizeof(chunk))) > 0) {
+        if (mbuf_append(&b, chunk, (size_t)n) != 0) {
+            perror("mbuf_append");
+            exit(1);
+        }
+    }
+    close(fd);
+    size_t total = b.length;
+    mbuf_free(&b);
+    return total;
+}
+
+static size_t fill_read_fd(const char *path) {
+    int fd = open_or_die(path);
+    Mbuf b;
+    mbuf_init(&b);
+    ssize_t n;
+    while ((n = mbuf_read_fd(&b, fd, CHUNK)) > 0) {
+    }
+    if (n < 0) {
+        perror("mbuf_read_fd");
+        exit(1);
+    }
+    close(fd);
+    size_t total = b.length;
+    mbuf_free(&b);
+    return total;
+}
+
+static void run(const char *name, size_t (*fill)(const char *), const char *path) {
+    fill(path); // warm the page cache so we time the buffer, not the disk
+    double t0 = now_sec();
+    size_t total = fill(path);
+    double dt = now_sec() - t0;
+    printf("%-10s %12zu bytes  %8.3f s  %9.1f MB/s\n",
+           name, total, dt, (double)total / dt / 1e6);
+}
+
+int main(int argc, char **argv) {
+    const char *path = NULL;
+    int made_temp = 0;
+    if (argc > 1) {
+        path = argv[1];
+    } else {
+        path = make_temp_file((size_t)256 * 1024 * 1024);
+        made_temp = 1;
+    }
+
+    run("push_byte", fill_push_byte, path);
+    run("append", fill_append, path);
+    run("read_fd", fill_read_fd, path);
+
+    if (made_temp) {
+        unlink(path);
+    }
+    return 0;
+}
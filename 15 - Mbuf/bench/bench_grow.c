@@ -0,0 +1,81 @@
+// bench_grow.c - grow one Mbuf to several GB: realloc doubling vs mmap/mremap
+//
+// Build (from "15 - Mbuf"):
+//   gcc -std=c17 -O2 -Wall -Wextra -Iinclude bench/bench_grow.c src/mbuf.c -o bench_grow
+// Run:
+//   ./bench_grow [GiB]     (default 4)
+//
+// Each mode runs in its own child process so ru_maxrss (peak RSS) is per mode.
+#define _DEFAULT_SOURCE
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include "mbuf.h"
+
+enum { CHUNK = 1024 * 1024 };
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+// Child: append CHUNK-sized pieces until we hit target bytes. Exit code 0 = ok.
+static int grow(size_t target, size_t threshold) {
+    static unsigned char chunk[CHUNK];
+    memset(chunk, 0xA5, sizeof(chunk));
+    mbuf_set_mmap_threshold(threshold);
+
+    Mbuf b;
+    mbuf_init(&b);
+    while (b.length < target) {
+        if (mbuf_append(&b, chunk, sizeof(chunk)) != 0) {
+            perror("mbuf_append");
+            return 1;
+        }
+    }
+    mbuf_free(&b);
+    return 0;
+}
+
+static void run(const char *name, size_t target, size_t threshold) {
+    double t0 = now_sec();
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("fork");
+        exit(1);
+    }
+    if (pid == 0) {
+        _exit(grow(target, threshold));
+    }
+    int status = 0;
+    struct rusage ru;
+    if (wait4(pid, &status, 0, &ru) < 0) {
+        perror("wait4");
+        exit(1);
+    }
+    double dt = now_sec() - t0;
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        printf("%-8s failed (status %d)\n", name, status);
+        return;
+    }
+    printf("%-8s %6.2f GiB  %7.3f s wall  %7.3f s sys  peak RSS %8.1f MiB\n",
+           name, (double)target / (1024.0 * 1024 * 1024), dt,
+           (double)ru.ru_stime.tv_sec + (double)ru.ru_stime.tv_usec / 1e6,
+           (double)ru.ru_maxrss / 1024.0);
+}
+
+int main(int argc, char **argv) {
+    double gib = argc > 1 ? atof(argv[1]) : 4.0;
+    size_t target = (size_t)(gib * 1024.0 * 1024.0 * 1024.0);
+
+    run("realloc", target, SIZE_MAX);
+    run("mremap", target, MBUF_MMAP_THRESHOLD_DEFAULT);
+    return 0;
+}
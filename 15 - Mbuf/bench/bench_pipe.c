@@ -0,0 +1,219 @@
+// bench_pipe.c - reader/worker hand-off: lock-free MbufPipe vs mutex/condvar queue
+//
+// Build (from "15 - Mbuf"):
+//   gcc -std=c17 -O2 -Wall -Wextra -pthread -Iinclude bench/bench_pipe.c src/mbuf.c src/mbuf_spsc.c -o bench_pipe
+// Run:
+//   ./bench_pipe [block_bytes] [blocks_in_flight] [total_MiB]   (default 65536 16 4096)
+//
+// The producer acquires an empty block, fills it, stamps the time and submits it.
+// The consumer receives it, reads every 64th byte (standing in for a parser),
+// records how long the block sat in the queue, and gives it back.
+// Both designs recycle the same set of blocks, so neither mallocs in the loop.
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include "mbuf.h"
+#include "mbuf_spsc.h"
+
+static size_t block_bytes = 65536;
+static size_t in_flight = 16;
+static size_t total_blocks;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+// First 8 bytes of each block carry the submit timestamp
+static void stamp(Mbuf *b) {
+    uint64_t t = now_ns();
+    memcpy(b->data, &t, sizeof(t));
+}
+
+static uint64_t hop_ns(const Mbuf *b) {
+    uint64_t t;
+    memcpy(&t, b->data, sizeof(t));
+    return now_ns() - t;
+}
+
+static void fill(Mbuf *b, size_t seq) {
+    memset(b->data, (int)(seq & 0xFF), block_bytes);
+    b->length = block_bytes;
+}
+
+static unsigned touch(const Mbuf *b) {
+    unsigned sum = 0;
+    for (size_t i = sizeof(uint64_t); i < b->length; i += 64) { // skip the timestamp
+        sum += b->data[i];
+    }
+    return sum;
+}
+
+struct result {
+    uint64_t hop_total;
+    uint64_t hop_max;
+    unsigned checksum;
+};
+
+
+/* ---- lock-free pipe ---- */
+
+static MbufPipe pipe_q;
+
+static void *pipe_producer(void *arg) {
+    (void)arg;
+    for (size_t i = 0; i < total_blocks; i++) {
+        Mbuf *b = mbuf_pipe_acquire(&pipe_q);
+        fill(b, i);
+        stamp(b);
+        mbuf_pipe_submit(&pipe_q, b);
+    }
+    mbuf_pipe_close(&pipe_q);
+    return NULL;
+}
+
+static void pipe_consume(struct result *res) {
+    Mbuf *b;
+    while ((b = mbuf_pipe_receive(&pipe_q)) != NULL) {
+        uint64_t hop = hop_ns(b);
+        res->hop_total += hop;
+        if (hop > res->hop_max) res->hop_max = hop;
+        res->checksum += touch(b);
+        mbuf_pipe_release(&pipe_q, b);
+    }
+}
+
+
+/* ---- mutex/condvar baseline: same two-queue shape, guarded by one lock ---- */
+
+struct locked_queue {
+    Mbuf **slots;
+    size_t cap, head, count;
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty;
+};
+
+static struct locked_queue lq_full, lq_free;
+static int lq_closed;
+
+static void lq_init(struct locked_queue *q, size_t cap) {
+    q->slots = calloc(cap, sizeof(*q->slots));
+    q->cap = cap;
+    q->head = 0;
+    q->count = 0;
+    pthread_mutex_init(&q->lock, NULL);
+    pthread_cond_init(&q->not_empty, NULL);
+}
+
+static void lq_push(struct locked_queue *q, Mbuf *b) {
+    pthread_mutex_lock(&q->lock);
+    q->slots[(q->head + q->count) % q->cap] = b; // never overfills: only cap blocks exist
+    q->count++;
+    pthread_cond_signal(&q->not_empty);
+    pthread_mutex_unlock(&q->lock);
+}
+
+// NULL only for the full queue after close
+static Mbuf *lq_pop(struct locked_queue *q) {
+    pthread_mutex_lock(&q->lock);
+    while (q->count == 0 && !(q == &lq_full && lq_closed)) {
+        pthread_cond_wait(&q->not_empty, &q->lock);
+    }
+    Mbuf *b = NULL;
+    if (q->count > 0) {
+        b = q->slots[q->head];
+        q->head = (q->head + 1) % q->cap;
+        q->count--;
+    }
+    pthread_mutex_unlock(&q->lock);
+    return b;
+}
+
+static void *lq_producer(void *arg) {
+    (void)arg;
+    for (size_t i = 0; i < total_blocks; i++) {
+        Mbuf *b = lq_pop(&lq_free);
+        fill(b, i);
+        stamp(b);
+        lq_push(&lq_full, b);
+    }
+    pthread_mutex_lock(&lq_full.lock);
+    lq_closed = 1;
+    pthread_cond_signal(&lq_full.not_empty);
+    pthread_mutex_unlock(&lq_full.lock);
+    return NULL;
+}
+
+static void lq_consume(struct result *res) {
+    Mbuf *b;
+    while ((b = lq_pop(&lq_full)) != NULL) {
+        uint64_t hop = hop_ns(b);
+        res->hop_total += hop;
+        if (hop > res->hop_max) res->hop_max = hop;
+        res->checksum += touch(b);
+        mbuf_clear(b);
+        lq_push(&lq_free, b);
+    }
+}
+
+
+static void report(const char *name, uint64_t elapsed, const struct result *res) {
+    double bytes = (double)total_blocks * (double)block_bytes;
+    printf("%-8s %8.2f GB/s  hop avg %9.0f ns  max %10llu ns  (checksum %u)\n",
+           name, bytes / (double)elapsed,
+           (double)res->hop_total / (double)total_blocks,
+           (unsigned long long)res->hop_max, res->checksum);
+}
+
+int main(int argc, char **argv) {
+    if (argc > 1) block_bytes = strtoull(argv[1], NULL, 10);
+    if (argc > 2) in_flight = strtoull(argv[2], NULL, 10);
+    size_t total_mib = argc > 3 ? strtoull(argv[3], NULL, 10) : 4096;
+    if (block_bytes < sizeof(uint64_t) || in_flight == 0) {
+        fprintf(stderr, "block_bytes must be >= 8 and blocks_in_flight >= 1\n");
+        return 2;
+    }
+    total_blocks = total_mib * 1024 * 1024 / block_bytes;
+
+    // lock-free
+    if (mbuf_pipe_init(&pipe_q, in_flight, block_bytes) != 0) {
+        perror("mbuf_pipe_init");
+        return 1;
+    }
+    struct result res = {0, 0, 0};
+    pthread_t th;
+    uint64_t t0 = now_ns();
+    pthread_create(&th, NULL, pipe_producer, NULL);
+    pipe_consume(&res);
+    pthread_join(th, NULL);
+    report("spsc", now_ns() - t0, &res);
+    mbuf_pipe_free(&pipe_q);
+
+    // mutex/condvar
+    Mbuf *blocks = calloc(in_flight, sizeof(Mbuf));
+    lq_init(&lq_full, in_flight);
+    lq_init(&lq_free, in_flight);
+    for (size_t i = 0; i < in_flight; i++) {
+        mbuf_init(&blocks[i]);
+        mbuf_reserve(&blocks[i], block_bytes);
+        lq_push(&lq_free, &blocks[i]);
+    }
+    struct result res2 = {0, 0, 0};
+    t0 = now_ns();
+    pthread_create(&th, NULL, lq_producer, NULL);
+    lq_consume(&res2);
+    pthread_join(th, NULL);
+    report("mutex", now_ns() - t0, &res2);
+    for (size_t i = 0; i < in_flight; i++) {
+        mbuf_free(&blocks[i]);
+    }
+    free(blocks);
+    free(lq_full.slots);
+    free(lq_free.slots);
+    return 0;
+}
@@ -0,0 +1,135 @@
+// bench_tokens.c - allocation counts for a token-heavy workload
+//
+// Build (from "15 - Mbuf"):
+//   gcc -std=c17 -O2 -Wall -Wextra -Iinclude bench/bench_tokens.c src/mbuf.c
+//       -Wl,--wrap=malloc,--wrap=realloc,--wrap=free -o bench_tokens
+// Run:
+//   ./bench_tokens [tokens]     (default 1,000,000)
+//
+// Every token gets its own buffer: init, push its bytes one at a time, free.
+// "legacy" replays the old mbuf_reserve (heap from the first byte, capacity 1,2,4,8,...),
+// "mbuf" is the current library with inline storage.
+// --wrap lets us count every malloc/realloc/free that reaches libc.
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "mbuf.h"
+
+static size_t n_malloc, n_realloc, n_free;
+
+void *__real_malloc(size_t size);
+void *__real_realloc(void *ptr, size_t size);
+void __real_free(void *ptr);
+
+void *__wrap_malloc(size_t size) {
+    n_malloc++;
+    return __real_malloc(size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size) {
+    n_realloc++;
+    return __real_realloc(ptr, size);
+}
+
+void __wrap_free(void *ptr) {
+    if (ptr != NULL) {
+        n_free++;
+    }
+    __real_free(ptr);
+}
+
+// The pre-inline-storage growth policy, kept here so we have something to compare against.
+typedef struct {
+    unsigned char *data;
+    size_t length;
+    size_t capacity;
+} LegacyBuf;
+
+static int legacy_reserve(LegacyBuf *b, size_t need) {
+    if (b->capacity >= need) {
+        return 0;
+    }
+    size_t new_capacity = b->capacity ? b->capacity : 1;
+    while (new_capacity < need) {
+        new_capacity *= 2;
+    }
+    unsigned char *new_data = realloc(b->data, new_capacity);
+    if (new_data == NULL) {
+        return -1;
+    }
+    b->data = new_data;
+    b->capacity = new_capacity;
+    return 0;
+}
+
+static int legacy_push_byte(LegacyBuf *b, unsigned char byte) {
+    if (legacy_reserve(b, b->length + 1) != 0) {
+        return -1;
+    }
+    b->data[b->length++] = byte;
+    return 0;
+}
+
+// Token lengths: mostly short words, some header-sized lines, a few long ones.
+static size_t token_len(uint32_t *seed) {
+    *seed = *seed * 1103515245u + 12345u;
+    uint32_t r = (*seed >> 8) % 100;
+    if (r < 80) return 1 + r % 12;        // words
+    if (r < 95) return 20 + r % 40;       // header / line fragments
+    return 64 + (r % 5) * 50;             // the odd long line
+}
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static void reset_counts(void) {
+    n_malloc = n_realloc = n_free = 0;
+}
+
+static void report(const char *name, size_t tokens, size_t bytes, double dt) {
+    printf("%-7s tokens=%zu bytes=%zu  malloc=%zu realloc=%zu free=%zu  (%.2f allocs/token)  %.3f s\n",
+           name, tokens, bytes, n_malloc, n_realloc, n_free,
+           (double)(n_malloc + n_realloc) / (double)tokens, dt);
+}
+
+int main(int argc, char **argv) {
+    size_t tokens = argc > 1 ? strtoull(argv[1], NULL, 10) : 1000000;
+    size_t bytes = 0;
+
+    uint32_t seed = 42;
+    reset_counts();
+    double t0 = now_sec();
+    for (size_t t = 0; t < tokens; t++) {
+        LegacyBuf b = { NULL, 0, 0 };
+        size_t len = token_len(&seed);
+        for (size_t i = 0; i < len; i++) {
+            legacy_push_byte(&b, (unsigned char)('a' + i % 26));
+        }
+        bytes += b.length;
+        free(b.data);
+    }
+    report("legacy", tokens, bytes, now_sec() - t0);
+
+    seed = 42;
+    bytes = 0;
+    reset_counts();
+    t0 = now_sec();
+    for (size_t t = 0; t < tokens; t++) {
+        Mbuf b;
+        mbuf_init(&b);
+        size_t len = token_len(&seed);
+        for (size_t i = 0; i < len; i++) {
+            mbuf_push_byte(&b, (unsigned char)('a' + i % 26));
+        }
+        bytes += b.length;
+        mbuf_free(&b);
+    }
+    report("mbuf", tokens, bytes, now_sec() - t0);
+    return 0;
+}
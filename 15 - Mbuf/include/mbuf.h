@@ -1,15 +1,28 @@
 #pragma once
 
 #include <stddef.h>
+#include <sys/types.h>  // ssize_t
 
 
+// Small payloads (tokens, short lines, headers) fit in inline_buf inside the struct,
+// so they never touch the heap. Once the data outgrows it we move to malloc'd memory.
+#define MBUF_INLINE_CAP 64
+
+// NOTE: while the buffer is inline, data points into the struct itself,
+// so an Mbuf must not be copied by value (pass Mbuf * around instead).
 typedef struct {
     // Placeholder for mbuf structure (e.g., data pointer, length, capacity)
     unsigned char *data;  // Pointer to the buffer data which looks like an array of bytes (aka these look like chars such as 'A', 'B', etc.)
     size_t length; // Current length of data in the buffer which tells us how many bytes are currently used in the buffer)
-    size_t capacity; 
+    size_t capacity;
+    int mapped; // 1 when data comes from mmap (see mbuf_set_mmap_threshold)
+    unsigned char inline_buf[MBUF_INLINE_CAP]; // storage used until we spill to the heap
 } Mbuf;
 
+// Once a buffer needs this much capacity it moves to an anonymous mmap and grows
+// with mremap, so the kernel moves page tables instead of us copying the payload.
+#define MBUF_MMAP_THRESHOLD_DEFAULT ((size_t)1024 * 1024)
+
 
 /* Lifecycle */
 void mbuf_init(Mbuf *b);
@@ -19,3 +32,15 @@ void mbuf_free(Mbuf *b);
 // Operations
 int mbuf_push_byte(Mbuf *b, unsigned char byte);
 int mbuf_reserve(Mbuf *b, size_t need);
+void mbuf_clear(Mbuf *b);
+
+// Process-wide mmap switch-over point (SIZE_MAX = never mmap, always realloc)
+void mbuf_set_mmap_threshold(size_t bytes);
+size_t mbuf_get_mmap_threshold(void);
+
+// Bulk operations
+// These do one capacity check per call instead of one per byte.
+int mbuf_append(Mbuf *b, const void *src, size_t n);       // copy n bytes onto the end
+unsigned char *mbuf_spare(Mbuf *b, size_t min, size_t *avail); // make room for >= min bytes, return the tail
+int mbuf_commit(Mbuf *b, size_t n);                        // mark n bytes written into the tail as used
+ssize_t mbuf_read_fd(Mbuf *b, int fd, size_t min);         // one read(2) straight into the tail
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <stddef.h>
+#include <sys/types.h>  // ssize_t
+
+// A segmented buffer: a linked list of fixed-size blocks.
+// Appending never moves bytes that are already stored (no realloc copies),
+// and there is never one huge allocation, only block_size pieces.
+// Bytes are consumed from the head block and written out with writev.
+
+#define MBUF_CHAIN_DEFAULT_BLOCK (64 * 1024)
+
+typedef struct MbufBlock {
+    struct MbufBlock *next;
+    size_t start;           // first unread byte in data
+    size_t end;             // one past the last written byte
+    unsigned char data[];   // block_size bytes follow the header
+} MbufBlock;
+
+typedef struct {
+    MbufBlock *head;        // oldest block, consume side
+    MbufBlock *tail;        // newest block, append side
+    MbufBlock *spare;       // one drained block kept for reuse
+    size_t block_size;      // payload bytes per block
+    size_t length;          // unread bytes across all blocks
+} MbufChain;
+
+
+/* Lifecycle */
+void mbuf_chain_init(MbufChain *c, size_t block_size); // 0 = MBUF_CHAIN_DEFAULT_BLOCK
+void mbuf_chain_free(MbufChain *c);
+
+
+// Appending
+int mbuf_chain_append(MbufChain *c, const void *src, size_t n);
+unsigned char *mbuf_chain_spare(MbufChain *c, size_t *avail); // free space in the tail block
+int mbuf_chain_commit(MbufChain *c, size_t n);
+ssize_t mbuf_chain_read_fd(MbufChain *c, int fd);
+
+// Iterating: start with *it = NULL, returns NULL after the last span
+const unsigned char *mbuf_chain_next(const MbufChain *c, const MbufBlock **it, size_t *len);
+
+// Consuming
+int mbuf_chain_consume(MbufChain *c, size_t n);
+ssize_t mbuf_chain_writev(MbufChain *c, int fd);  // one writev, consumes what was written
+int mbuf_chain_flush(MbufChain *c, int fd);       // writev until empty
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <stdio.h>
+#include <stddef.h>
+#include "mbuf.h"
+
+// Process-wide pool of Mbuf storage, so tools that churn through many small
+// files can reuse buffers instead of going back to malloc/free every time.
+//
+// Storage is kept in power-of-two size classes (MBUF_POOL_MIN_CLASS..MBUF_POOL_MAX_CLASS).
+// Each thread has a small cache per class in front of the shared free lists, and the
+// total memory parked in the pool never exceeds the limit.
+//
+//   Mbuf b;
+//   mbuf_pool_get(&b, 4096);   // instead of mbuf_init + mbuf_reserve
+//   ...use b like any Mbuf...
+//   mbuf_pool_put(&b);         // instead of mbuf_free
+
+#define MBUF_POOL_MIN_CLASS 128                          // anything smaller stays inline
+#define MBUF_POOL_MAX_CLASS ((size_t)512 * 1024)         // stays under the mmap threshold
+#define MBUF_POOL_DEFAULT_LIMIT ((size_t)64 * 1024 * 1024)
+
+typedef struct {
+    size_t hits;        // gets served from a thread cache or shared list
+    size_t misses;      // gets that had to malloc
+    size_t puts;        // storage handed back and kept
+    size_t drops;       // storage handed back but freed (over the limit / not poolable)
+    size_t bytes_held;  // bytes currently parked in the pool
+    size_t high_water;  // most bytes ever parked at once
+    size_t limit;       // cap on bytes_held
+} MbufPoolStats;
+
+
+int mbuf_pool_get(Mbuf *b, size_t need);  // initialize b with capacity >= need
+void mbuf_pool_put(Mbuf *b);              // give b's storage back, b is re-initialized
+
+void mbuf_pool_set_limit(size_t bytes);
+void mbuf_pool_trim(void);                // free everything in the shared lists
+
+void mbuf_pool_stats(MbufPoolStats *out);
+void mbuf_pool_dump(FILE *to);
+void mbuf_pool_dump_at_exit(void);        // print the counters to stderr when the program exits
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <stddef.h>
+#include <sys/types.h>  // ssize_t
+
+// A ring buffer for streaming: the producer appends at the write cursor (tail),
+// the parser consumes from the read cursor (head), and nothing is ever memmove'd.
+//
+// head and tail are free-running byte counters; position in data is counter & (capacity - 1),
+// which is why capacity is always a power of two.
+//
+// In mirrored mode the same pages are mapped twice back to back, so data[i] and
+// data[i + capacity] are the same byte and every span is contiguous, even across the wrap.
+
+typedef struct {
+    unsigned char *data;
+    size_t capacity;   // power of two
+    size_t head;       // bytes consumed so far (read cursor)
+    size_t tail;       // bytes produced so far (write cursor)
+    int mirrored;      // 1 = data is a double mapping of capacity bytes
+} MbufRing;
+
+
+/* Lifecycle */
+int mbuf_ring_init(MbufRing *r, size_t capacity);          // heap storage, capacity rounded up to 2^n
+int mbuf_ring_init_mirrored(MbufRing *r, size_t capacity); // double-mapped, rounded up to whole pages
+void mbuf_ring_free(MbufRing *r);
+
+
+// State
+size_t mbuf_ring_length(const MbufRing *r); // readable bytes
+size_t mbuf_ring_space(const MbufRing *r);  // writable bytes
+
+// Zero-copy spans
+unsigned char *mbuf_ring_read_span(MbufRing *r, size_t *len);  // contiguous readable bytes at head
+int mbuf_ring_consume(MbufRing *r, size_t n);
+unsigned char *mbuf_ring_write_span(MbufRing *r, size_t *len); // contiguous free bytes at tail
+int mbuf_ring_commit(MbufRing *r, size_t n);
+
+// Copying helpers (handle the wrap for you)
+size_t mbuf_ring_write(MbufRing *r, const void *src, size_t n); // returns bytes that fit
+size_t mbuf_ring_read(MbufRing *r, void *dst, size_t n);        // returns bytes copied out
+ssize_t mbuf_ring_read_fd(MbufRing *r, int fd);                 // one read(2) into the write span
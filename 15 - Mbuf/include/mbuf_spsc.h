@@ -0,0 +1,55 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdatomic.h>
+#include "mbuf.h"
+
+// Lock-free single-producer/single-consumer queue of Mbuf pointers, plus an
+// MbufPipe that pairs two of them so one thread can do I/O into blocks while
+// another parses them:
+//
+//   producer --acquire-- [free queue] <--release-- consumer
+//   producer --submit--> [full queue] --receive--> consumer
+//
+// All blocks are allocated in mbuf_pipe_init; after that no malloc happens as
+// long as the producer stays within block_capacity.
+
+#define MBUF_CACHE_LINE 64
+
+typedef struct {
+    Mbuf **slots;
+    size_t mask;                                  // capacity - 1 (capacity is 2^n)
+    _Alignas(MBUF_CACHE_LINE) atomic_size_t head; // next slot to pop (consumer owns)
+    size_t tail_cache;                            // consumer's last look at tail
+    _Alignas(MBUF_CACHE_LINE) atomic_size_t tail; // next slot to push (producer owns)
+    size_t head_cache;                            // producer's last look at head
+} MbufSpsc;
+
+typedef struct {
+    MbufSpsc full;      // filled blocks, producer -> consumer
+    MbufSpsc free;      // recycled blocks, consumer -> producer
+    Mbuf *blocks;       // every block the pipe owns
+    size_t nblocks;
+    atomic_int closed;  // producer is done
+} MbufPipe;
+
+
+/* Queue */
+int mbuf_spsc_init(MbufSpsc *q, size_t capacity); // rounded up to 2^n
+void mbuf_spsc_free(MbufSpsc *q);
+int mbuf_spsc_push(MbufSpsc *q, Mbuf *b);         // producer only; 0 ok, -1 full
+Mbuf *mbuf_spsc_pop(MbufSpsc *q);                 // consumer only; NULL when empty
+
+
+/* Pipe */
+int mbuf_pipe_init(MbufPipe *p, size_t nblocks, size_t block_capacity);
+void mbuf_pipe_free(MbufPipe *p);
+
+// producer side
+Mbuf *mbuf_pipe_acquire(MbufPipe *p);             // empty block, waits for one to come back
+void mbuf_pipe_submit(MbufPipe *p, Mbuf *b);
+void mbuf_pipe_close(MbufPipe *p);
+
+// consumer side
+Mbuf *mbuf_pipe_receive(MbufPipe *p);             // waits; NULL once closed and drained
+void mbuf_pipe_release(MbufPipe *p, Mbuf *b);
@@ -1,8 +1,11 @@
+#define _GNU_SOURCE  // mremap
 #include <stdio.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
+#include <unistd.h>
+#include <sys/mman.h>
 #include "mbuf.h"
 
 //This project is meant to implement a memory buffer (mbuf), which is a dynamic array that can grow as needed to hold data.
@@ -21,24 +24,74 @@
 
 
 
+// Capacity at which mbuf_reserve stops using realloc and switches to mmap/mremap.
+// Shared by every Mbuf in the process, like mallopt(M_MMAP_THRESHOLD).
+static size_t mmap_threshold = MBUF_MMAP_THRESHOLD_DEFAULT;
+
+void mbuf_set_mmap_threshold(size_t bytes) {
+    mmap_threshold = bytes;
+}
+
+size_t mbuf_get_mmap_threshold(void) {
+    return mmap_threshold;
+}
+
+// True while the data still lives in the struct's inline_buf (nothing to free/realloc)
+static int mbuf_is_inline(const Mbuf *buff) {
+    return buff->data == buff->inline_buf;
+}
+
 void mbuf_init(Mbuf *buff) {
     // we take in a pointer to an mbuf structure and call that pointer "buff"
     // Initialize the mbuf structure members to default values 
-    // (e.g., NULL pointers, zero lengths)
-    buff->data = NULL; 
+    // (zero length, data pointing at the inline storage)
+    buff->data = buff->inline_buf;
     buff->length = 0;
-    buff-> capacity = 0;
+    buff-> capacity = MBUF_INLINE_CAP;
+    buff->mapped = 0;
 }
 
 void mbuf_free(Mbuf *buff) {
     if (buff == NULL) {
         return; // Nothing to free
     }
-    free(buff->data); // Free the allocated data buffer
-    buff->data = NULL; // Set pointer to NULL to avoid dangling pointer
+    if (buff->mapped) {
+        munmap(buff->data, buff->capacity); // mmap'd pages go back with munmap, not free
+    } else if (!mbuf_is_inline(buff)) {
+        free(buff->data); // Free the allocated data buffer
+    }
+    // Back to the freshly initialized state (inline storage, empty)
+    buff->data = buff->inline_buf;
     buff->length = 0; // Reset length
-    buff->capacity = 0; // Reset capacity
+    buff->capacity = MBUF_INLINE_CAP; // Reset capacity
+    buff->mapped = 0;
 }
+
+// Grow into anonymous mmap'd memory. new_capacity is already page-rounded.
+// If we're mapped already, mremap lets the kernel move the page tables instead of the bytes.
+// returns: new data pointer, or NULL with errno set
+static unsigned char *mbuf_grow_mapped(Mbuf *buff, size_t new_capacity) {
+    void *p;
+#ifdef MREMAP_MAYMOVE
+    if (buff->mapped) {
+        p = mremap(buff->data, buff->capacity, new_capacity, MREMAP_MAYMOVE);
+        return p == MAP_FAILED ? NULL : p;
+    }
+#endif
+    p = mmap(NULL, new_capacity, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) {
+        return NULL;
+    }
+    // First time over the threshold (or no mremap on this OS): copy once, drop the old storage
+    memcpy(p, buff->data, buff->length);
+    if (buff->mapped) {
+        munmap(buff->data, buff->capacity);
+    } else if (!mbuf_is_inline(buff)) {
+        free(buff->data);
+    }
+    return p;
+}
+
 int mbuf_reserve(Mbuf *buff, size_t need) {
     if (buff->capacity >= need) {
         return 0; // Already have enough capacity
@@ -52,7 +105,35 @@ int mbuf_reserve(Mbuf *buff, size_t need) {
 
         new_capacity *= 2; // Double the capacity
     }
-    unsigned char *new_data = realloc(buff->data, new_capacity);
+    unsigned char *new_data;
+    if (new_capacity >= mmap_threshold || buff->mapped) {
+        // Big buffer: round up to whole pages and let mmap/mremap handle it
+        // (once mapped we stay mapped, even if the threshold is raised later)
+        size_t page = (size_t)sysconf(_SC_PAGESIZE);
+        if (new_capacity > SIZE_MAX - (page - 1)) {
+            errno = ENOMEM;
+            return -1;
+        }
+        new_capacity = (new_capacity + page - 1) & ~(page - 1);
+        new_data = mbuf_grow_mapped(buff, new_capacity);
+        if (new_data == NULL) {
+            errno = ENOMEM;
+            return -1;
+        }
+        buff->data = new_data;
+        buff->capacity = new_capacity;
+        buff->mapped = 1;
+        return 0;
+    }
+    if (mbuf_is_inline(buff)) {
+        // First spill to the heap: realloc can't move inline_buf, so malloc + copy
+        new_data = malloc(new_capacity);
+        if (new_data != NULL) {
+            memcpy(new_data, buff->inline_buf, buff->length);
+        }
+    } else {
+        new_data = realloc(buff->data, new_capacity);
+    }
 
     if (new_data == NULL) {
         errno = ENOMEM;      
@@ -76,8 +157,66 @@ void mbuf_clear(Mbuf *buff) {
     buff->length = 0; // Simply reset the length to zero
 }
 
+// Append n bytes from src in one go.
+// Same growth rules as mbuf_push_byte, but we only check capacity once and copy with memcpy.
+int mbuf_append(Mbuf *buff, const void *src, size_t n) {
+    if (n == 0) {
+        return 0;
+    }
+    if (n > SIZE_MAX - buff->length) {
+        errno = EOVERFLOW;
+        return -1; // length + n would wrap around
+    }
+    if (mbuf_reserve(buff, buff->length + n) != 0) {
+        return -1;
+    }
+    memcpy(buff->data + buff->length, src, n);
+    buff->length += n;
+    return 0;
+}
 
-int main() {
-    // Example usage of mbuf.c functions would go here
+// Make sure there are at least min free bytes after the data and hand back a pointer to them.
+// *avail gets the real amount of free space (can be more than min because of doubling).
+// The caller writes into the tail and then calls mbuf_commit with how much it actually wrote.
+unsigned char *mbuf_spare(Mbuf *buff, size_t min, size_t *avail) {
+    if (min > SIZE_MAX - buff->length) {
+        errno = EOVERFLOW;
+        return NULL;
+    }
+    if (mbuf_reserve(buff, buff->length + min) != 0) {
+        return NULL;
+    }
+    if (avail) {
+        *avail = buff->capacity - buff->length;
+    }
+    return buff->data + buff->length;
+}
+
+// Mark n bytes written into the spare tail as part of the data.
+int mbuf_commit(Mbuf *buff, size_t n) {
+    if (n > buff->capacity - buff->length) {
+        errno = EINVAL;
+        return -1; // caller claims to have written past the end
+    }
+    buff->length += n;
     return 0;
+}
+
+// Do one read(2) from fd directly into the spare tail (no bounce buffer).
+// min: how much free space to guarantee before reading (0 picks a default).
+// returns: bytes read, 0 on EOF, -1 on error (errno set). EINTR is retried.
+ssize_t mbuf_read_fd(Mbuf *buff, int fd, size_t min) {
+    size_t avail = 0;
+    unsigned char *tail = mbuf_spare(buff, min ? min : 4096, &avail);
+    if (tail == NULL) {
+        return -1;
+    }
+    ssize_t got;
+    do {
+        got = read(fd, tail, avail);
+    } while (got < 0 && errno == EINTR);
+    if (got > 0) {
+        buff->length += (size_t)got;
+    }
+    return got;
 }
\ No newline at end of file
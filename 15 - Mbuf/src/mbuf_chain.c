@@ -0,0 +1,229 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/uio.h>
+#include "mbuf_chain.h"
+
+// A plain Mbuf has to realloc (and copy everything) when it doubles, and right after
+// doubling up to half of it is unused. For multi-GB accumulations that hurts twice.
+// Here the data lives in a chain of fixed-size blocks instead:
+//   head -> [####....] -> [########] -> [###.....] <- tail
+// Appends fill the tail block and link a new one when it's full; old bytes never move.
+// Consuming advances head->start and frees blocks once they are fully read.
+
+// How many spans we hand to one writev call (Linux IOV_MAX is 1024)
+enum { CHAIN_IOV_BATCH = 64 };
+
+
+void mbuf_chain_init(MbufChain *c, size_t block_size) {
+    c->head = NULL;
+    c->tail = NULL;
+    c->spare = NULL;
+    c->block_size = block_size ? block_size : MBUF_CHAIN_DEFAULT_BLOCK;
+    c->length = 0;
+}
+
+void mbuf_chain_free(MbufChain *c) {
+    if (c == NULL) {
+        return;
+    }
+    MbufBlock *blk = c->head;
+    while (blk != NULL) {
+        MbufBlock *next = blk->next;
+        free(blk);
+        blk = next;
+    }
+    free(c->spare);
+    c->head = NULL;
+    c->tail = NULL;
+    c->spare = NULL;
+    c->length = 0;
+}
+
+// Link a fresh (or recycled) empty block at the tail.
+static MbufBlock *chain_add_block(MbufChain *c) {
+    MbufBlock *blk = c->spare;
+    if (blk != NULL) {
+        c->spare = NULL;
+    } else {
+        if (c->block_size > SIZE_MAX - sizeof(MbufBlock)) {
+            errno = EOVERFLOW;
+            return NULL;
+        }
+        blk = malloc(sizeof(MbufBlock) + c->block_size);
+        if (blk == NULL) {
+            errno = ENOMEM;
+            return NULL;
+        }
+    }
+    blk->next = NULL;
+    blk->start = 0;
+    blk->end = 0;
+    if (c->tail != NULL) {
+        c->tail->next = blk;
+    } else {
+        c->head = blk;
+    }
+    c->tail = blk;
+    return blk;
+}
+
+// Unlink the (fully read) head block; keep it as the spare if we don't have one.
+static void chain_drop_head(MbufChain *c) {
+    MbufBlock *blk = c->head;
+    c->head = blk->next;
+    if (c->head == NULL) {
+        c->tail = NULL;
+    }
+    if (c->spare == NULL) {
+        c->spare = blk;
+    } else {
+        free(blk);
+    }
+}
+
+// Free space at the end of the tail block, adding a block if the tail is full.
+unsigned char *mbuf_chain_spare(MbufChain *c, size_t *avail) {
+    MbufBlock *blk = c->tail;
+    if (blk == NULL || blk->end == c->block_size) {
+        blk = chain_add_block(c);
+        if (blk == NULL) {
+            return NULL;
+        }
+    }
+    if (avail) {
+        *avail = c->block_size - blk->end;
+    }
+    return blk->data + blk->end;
+}
+
+int mbuf_chain_commit(MbufChain *c, size_t n) {
+    MbufBlock *blk = c->tail;
+    if (blk == NULL || n > c->block_size - blk->end) {
+        errno = EINVAL;
+        return -1; // more than mbuf_chain_spare handed out
+    }
+    blk->end += n;
+    c->length += n;
+    return 0;
+}
+
+int mbuf_chain_append(MbufChain *c, const void *src, size_t n) {
+    const unsigned char *p = src;
+    while (n > 0) {
+        size_t avail = 0;
+        unsigned char *dst = mbuf_chain_spare(c, &avail);
+        if (dst == NULL) {
+            return -1;
+        }
+        size_t take = n < avail ? n : avail;
+        memcpy(dst, p, take);
+        c->tail->end += take;
+        c->length += take;
+        p += take;
+        n -= take;
+    }
+    return 0;
+}
+
+// One read(2) into the tail block. returns bytes read, 0 on EOF, -1 on error.
+ssize_t mbuf_chain_read_fd(MbufChain *c, int fd) {
+    size_t avail = 0;
+    unsigned char *dst = mbuf_chain_spare(c, &avail);
+    if (dst == NULL) {
+        return -1;
+    }
+    ssize_t got;
+    do {
+        got = read(fd, dst, avail);
+    } while (got < 0 && errno == EINTR);
+    if (got > 0) {
+        c->tail->end += (size_t)got;
+        c->length += (size_t)got;
+    }
+    return got;
+}
+
+// Walk the readable spans in order.
+// it: iterator state, set *it = NULL before the first call
+// len: gets the span length
+// returns: pointer to the span, or NULL when there are no more
+const unsigned char *mbuf_chain_next(const MbufChain *c, const MbufBlock **it, size_t *len) {
+    const MbufBlock *blk = (*it == NULL) ? c->head : (*it)->next;
+    // skip empty blocks (e.g. a tail that was just linked)
+    while (blk != NULL && blk->start == blk->end) {
+        blk = blk->next;
+    }
+    *it = blk;
+    if (blk == NULL) {
+        *len = 0;
+        return NULL;
+    }
+    *len = blk->end - blk->start;
+    return blk->data + blk->start;
+}
+
+// Drop n bytes from the front, freeing blocks as they empty.
+int mbuf_chain_consume(MbufChain *c, size_t n) {
+    if (n > c->length) {
+        errno = EINVAL;
+        return -1;
+    }
+    c->length -= n;
+    while (n > 0) {
+        MbufBlock *blk = c->head;
+        size_t have = blk->end - blk->start;
+        if (n < have) {
+            blk->start += n;
+            break;
+        }
+        n -= have;
+        chain_drop_head(c);
+    }
+    // A tail that has been read completely can start over from offset 0
+    if (c->head != NULL && c->head == c->tail && c->head->start == c->head->end) {
+        c->head->start = 0;
+        c->head->end = 0;
+    }
+    return 0;
+}
+
+// Gather up to CHAIN_IOV_BATCH spans into one writev and consume whatever got written.
+// returns: bytes written (0 if the chain is empty), -1 on error. EINTR is retried.
+ssize_t mbuf_chain_writev(MbufChain *c, int fd) {
+    struct iovec iov[CHAIN_IOV_BATCH];
+    int cnt = 0;
+    const MbufBlock *it = NULL;
+    size_t len = 0;
+    const unsigned char *span;
+    while (cnt < CHAIN_IOV_BATCH && (span = mbuf_chain_next(c, &it, &len)) != NULL) {
+        iov[cnt].iov_base = (void *)span;
+        iov[cnt].iov_len = len;
+        cnt++;
+    }
+    if (cnt == 0) {
+        return 0;
+    }
+    ssize_t wrote;
+    do {
+        wrote = writev(fd, iov, cnt);
+    } while (wrote < 0 && errno == EINTR);
+    if (wrote > 0) {
+        mbuf_chain_consume(c, (size_t)wrote);
+    }
+    return wrote;
+}
+
+// Keep calling writev until everything buffered has been written.
+int mbuf_chain_flush(MbufChain *c, int fd) {
+    while (c->length > 0) {
+        if (mbuf_chain_writev(c, fd) < 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,244 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "mbuf_pool.h"
+
+// How the pool is laid out:
+//
+//   thread cache (no locks)        shared lists (one mutex)
+//   class 0 (128 B):  [p][p]   ->  class 0: p -> p -> p
+//   class 1 (256 B):  [p]      ->  class 1: p
+//   ...                             ...
+//
+// mbuf_pool_get looks in this thread's cache first, then the shared list, then mallocs.
+// mbuf_pool_put does the reverse. Free buffers are linked through their own first bytes,
+// so the lists need no extra memory.
+//
+// Mbuf capacities above the inline size are always powers of two (mbuf_reserve doubles
+// from MBUF_INLINE_CAP), so a returned buffer normally lands exactly on a class.
+
+enum {
+    POOL_CLASSES = 13,    // 128 B .. 512 KiB
+    TCACHE_SLOTS = 8      // per class, per thread
+};
+
+struct free_node {
+    struct free_node *next;
+};
+
+struct tcache {
+    void *slot[POOL_CLASSES][TCACHE_SLOTS];
+    unsigned count[POOL_CLASSES];
+    int registered;       // thread-exit flush hooked up
+};
+
+static pthread_mutex_t pool_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct free_node *shared[POOL_CLASSES];
+
+static _Thread_local struct tcache tc;
+static pthread_key_t tc_key;
+static pthread_once_t tc_once = PTHREAD_ONCE_INIT;
+
+static atomic_size_t stat_hits, stat_misses, stat_puts, stat_drops;
+static atomic_size_t bytes_held, high_water;
+static atomic_size_t pool_limit = MBUF_POOL_DEFAULT_LIMIT;
+
+
+// Smallest class that fits need, or -1 if need is bigger than the largest class
+static int class_for_need(size_t need) {
+    size_t size = MBUF_POOL_MIN_CLASS;
+    for (int c = 0; c < POOL_CLASSES; c++, size <<= 1) {
+        if (need <= size) {
+            return c;
+        }
+    }
+    return -1;
+}
+
+// Class whose size is exactly capacity, or -1
+static int class_for_capacity(size_t capacity) {
+    size_t size = MBUF_POOL_MIN_CLASS;
+    for (int c = 0; c < POOL_CLASSES; c++, size <<= 1) {
+        if (capacity == size) {
+            return c;
+        }
+    }
+    return -1;
+}
+
+static size_t class_size(int c) {
+    return (size_t)MBUF_POOL_MIN_CLASS << c;
+}
+
+// Try to account for size more bytes in the pool; fails if that would break the limit.
+static int held_add(size_t size) {
+    size_t cur = atomic_load(&bytes_held);
+    do {
+        if (cur + size > atomic_load(&pool_limit)) {
+            return -1;
+        }
+    } while (!atomic_compare_exchange_weak(&bytes_held, &cur, cur + size));
+
+    size_t now = cur + size;
+    size_t hw = atomic_load(&high_water);
+    while (now > hw && !atomic_compare_exchange_weak(&high_water, &hw, now)) {
+    }
+    return 0;
+}
+
+static void held_sub(size_t size) {
+    atomic_fetch_sub(&bytes_held, size);
+}
+
+// A thread is going away: move its cached buffers to the shared lists
+static void tcache_flush(void *arg) {
+    struct tcache *t = arg;
+    pthread_mutex_lock(&pool_lock);
+    for (int c = 0; c < POOL_CLASSES; c++) {
+        while (t->count[c] > 0) {
+            struct free_node *node = t->slot[c][--t->count[c]];
+            node->next = shared[c];
+            shared[c] = node;
+        }
+    }
+    pthread_mutex_unlock(&pool_lock);
+}
+
+static void tcache_key_init(void) {
+    pthread_key_create(&tc_key, tcache_flush);
+}
+
+// Make sure tcache_flush runs when this thread exits
+static void tcache_register(void) {
+    if (!tc.registered) {
+        pthread_once(&tc_once, tcache_key_init);
+        pthread_setspecific(tc_key, &tc);
+        tc.registered = 1;
+    }
+}
+
+int mbuf_pool_get(Mbuf *b, size_t need) {
+    mbuf_init(b);
+    if (need <= MBUF_INLINE_CAP) {
+        return 0; // inline storage already covers it, nothing to pool
+    }
+    int c = class_for_need(need);
+    if (c < 0) {
+        // Too big to pool: plain growth (may go to mmap)
+        atomic_fetch_add(&stat_misses, 1);
+        return mbuf_reserve(b, need);
+    }
+
+    void *mem = NULL;
+    if (tc.count[c] > 0) {
+        mem = tc.slot[c][--tc.count[c]];
+    } else {
+        pthread_mutex_lock(&pool_lock);
+        if (shared[c] != NULL) {
+            mem = shared[c];
+            shared[c] = shared[c]->next;
+        }
+        pthread_mutex_unlock(&pool_lock);
+    }
+
+    if (mem != NULL) {
+        held_sub(class_size(c));
+        atomic_fetch_add(&stat_hits, 1);
+    } else {
+        mem = malloc(class_size(c));
+        if (mem == NULL) {
+            errno = ENOMEM;
+            return -1;
+        }
+        atomic_fetch_add(&stat_misses, 1);
+    }
+    b->data = mem;
+    b->capacity = class_size(c);
+    return 0;
+}
+
+void mbuf_pool_put(Mbuf *b) {
+    if (b == NULL) {
+        return;
+    }
+    if (b->data == b->inline_buf) {
+        mbuf_free(b); // never left the struct, nothing to pool
+        return;
+    }
+    int c = b->mapped ? -1 : class_for_capacity(b->capacity);
+    if (c < 0 || held_add(class_size(c)) != 0) {
+        // mmap'd, odd-sized, or the pool is at its limit: just release it
+        atomic_fetch_add(&stat_drops, 1);
+        mbuf_free(b);
+        return;
+    }
+
+    if (tc.count[c] < TCACHE_SLOTS) {
+        tcache_register();
+        tc.slot[c][tc.count[c]++] = b->data;
+    } else {
+        struct free_node *node = (struct free_node *)b->data;
+        pthread_mutex_lock(&pool_lock);
+        node->next = shared[c];
+        shared[c] = node;
+        pthread_mutex_unlock(&pool_lock);
+    }
+    atomic_fetch_add(&stat_puts, 1);
+    mbuf_init(b); // storage now belongs to the pool
+}
+
+void mbuf_pool_set_limit(size_t bytes) {
+    atomic_store(&pool_limit, bytes);
+}
+
+// Free the shared lists (thread caches are left alone; they're small and owned by their threads)
+void mbuf_pool_trim(void) {
+    pthread_mutex_lock(&pool_lock);
+    for (int c = 0; c < POOL_CLASSES; c++) {
+        while (shared[c] != NULL) {
+            struct free_node *node = shared[c];
+            shared[c] = node->next;
+            free(node);
+            held_sub(class_size(c));
+        }
+    }
+    pthread_mutex_unlock(&pool_lock);
+}
+
+void mbuf_pool_stats(MbufPoolStats *out) {
+    out->hits = atomic_load(&stat_hits);
+    out->misses = atomic_load(&stat_misses);
+    out->puts = atomic_load(&stat_puts);
+    out->drops = atomic_load(&stat_drops);
+    out->bytes_held = atomic_load(&bytes_held);
+    out->high_water = atomic_load(&high_water);
+    out->limit = atomic_load(&pool_limit);
+}
+
+void mbuf_pool_dump(FILE *to) {
+    MbufPoolStats s;
+    mbuf_pool_stats(&s);
+    size_t gets = s.hits + s.misses;
+    fprintf(to,
+        "mbuf_pool: hits=%zu misses=%zu (%.1f%% hit) puts=%zu drops=%zu\n"
+        "mbuf_pool: held=%zu bytes high_water=%zu bytes limit=%zu bytes\n",
+        s.hits, s.misses, gets ? 100.0 * (double)s.hits / (double)gets : 0.0,
+        s.puts, s.drops, s.bytes_held, s.high_water, s.limit);
+}
+
+static void dump_to_stderr(void) {
+    mbuf_pool_dump(stderr);
+}
+
+void mbuf_pool_dump_at_exit(void) {
+    static int registered = 0;
+    if (!registered) {
+        atexit(dump_to_stderr);
+        registered = 1;
+    }
+}
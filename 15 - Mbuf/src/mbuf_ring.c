@@ -0,0 +1,223 @@
+#define _GNU_SOURCE  // memfd_create
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "mbuf_ring.h"
+
+// With a plain Mbuf a stream parser appends at the end and, after consuming a message,
+// has to memmove the leftovers to the front (or start a new buffer). A ring keeps two
+// cursors instead, so consuming is just head += n.
+//
+//   data: [....RRRRRRRRWWWW....]      R = readable (head..tail), W = writable
+//               ^head   ^tail
+//
+// The catch with a normal ring is the wrap: a message that runs past the end of data is
+// split into two spans. The mirrored variant maps the same physical pages twice:
+//
+//   virtual: [ page0 page1 ... pageN | page0 page1 ... pageN ]
+//
+// so a span that starts near the end just keeps going into the second copy.
+
+
+// Round n up to a power of two (0 stays 0 so callers can reject it)
+static size_t round_pow2(size_t n) {
+    if (n == 0 || n > (SIZE_MAX >> 1) + 1) {
+        return 0;
+    }
+    size_t p = 1;
+    while (p < n) {
+        p <<= 1;
+    }
+    return p;
+}
+
+int mbuf_ring_init(MbufRing *r, size_t capacity) {
+    size_t cap = round_pow2(capacity);
+    if (cap == 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    r->data = malloc(cap);
+    if (r->data == NULL) {
+        errno = ENOMEM;
+        return -1;
+    }
+    r->capacity = cap;
+    r->head = 0;
+    r->tail = 0;
+    r->mirrored = 0;
+    return 0;
+}
+
+int mbuf_ring_init_mirrored(MbufRing *r, size_t capacity) {
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t cap = round_pow2(capacity < page ? page : capacity); // pages are 2^n too
+    if (cap == 0 || cap > SIZE_MAX / 2) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    // Anonymous file that backs both views
+    int fd = memfd_create("mbuf_ring", MFD_CLOEXEC);
+    if (fd < 0) {
+        return -1;
+    }
+    if (ftruncate(fd, (off_t)cap) != 0) {
+        int saved = errno;
+        close(fd);
+        errno = saved;
+        return -1;
+    }
+
+    // Reserve 2 * cap of address space, then map the file over each half
+    unsigned char *base = mmap(NULL, 2 * cap, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) {
+        int saved = errno;
+        close(fd);
+        errno = saved;
+        return -1;
+    }
+    if (mmap(base, cap, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED ||
+        mmap(base + cap, cap, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED) {
+        int saved = errno;
+        munmap(base, 2 * cap);
+        close(fd);
+        errno = saved;
+        return -1;
+    }
+    close(fd); // the mappings keep the pages alive
+
+    r->data = base;
+    r->capacity = cap;
+    r->head = 0;
+    r->tail = 0;
+    r->mirrored = 1;
+    return 0;
+}
+
+void mbuf_ring_free(MbufRing *r) {
+    if (r == NULL) {
+        return;
+    }
+    if (r->mirrored) {
+        munmap(r->data, 2 * r->capacity);
+    } else {
+        free(r->data);
+    }
+    r->data = NULL;
+    r->capacity = 0;
+    r->head = 0;
+    r->tail = 0;
+    r->mirrored = 0;
+}
+
+size_t mbuf_ring_length(const MbufRing *r) {
+    return r->tail - r->head; // counters are free-running, unsigned wrap makes this right
+}
+
+size_t mbuf_ring_space(const MbufRing *r) {
+    return r->capacity - (r->tail - r->head);
+}
+
+// Contiguous readable bytes starting at the read cursor.
+// Without mirroring this stops at the end of data; call again after consuming for the rest.
+unsigned char *mbuf_ring_read_span(MbufRing *r, size_t *len) {
+    size_t idx = r->head & (r->capacity - 1);
+    size_t n = mbuf_ring_length(r);
+    if (!r->mirrored && n > r->capacity - idx) {
+        n = r->capacity - idx;
+    }
+    *len = n;
+    return r->data + idx;
+}
+
+int mbuf_ring_consume(MbufRing *r, size_t n) {
+    if (n > mbuf_ring_length(r)) {
+        errno = EINVAL;
+        return -1;
+    }
+    r->head += n;
+    if (r->head == r->tail) {
+        // Empty: rewind both cursors so the next write span is as long as possible
+        r->head = 0;
+        r->tail = 0;
+    }
+    return 0;
+}
+
+// Contiguous free bytes starting at the write cursor.
+unsigned char *mbuf_ring_write_span(MbufRing *r, size_t *len) {
+    size_t idx = r->tail & (r->capacity - 1);
+    size_t n = mbuf_ring_space(r);
+    if (!r->mirrored && n > r->capacity - idx) {
+        n = r->capacity - idx;
+    }
+    *len = n;
+    return r->data + idx;
+}
+
+int mbuf_ring_commit(MbufRing *r, size_t n) {
+    if (n > mbuf_ring_space(r)) {
+        errno = EINVAL;
+        return -1;
+    }
+    r->tail += n;
+    return 0;
+}
+
+size_t mbuf_ring_write(MbufRing *r, const void *src, size_t n) {
+    const unsigned char *p = src;
+    size_t done = 0;
+    while (done < n) {
+        size_t len = 0;
+        unsigned char *dst = mbuf_ring_write_span(r, &len);
+        if (len == 0) {
+            break; // full
+        }
+        size_t take = (n - done) < len ? (n - done) : len;
+        memcpy(dst, p + done, take);
+        r->tail += take;
+        done += take;
+    }
+    return done;
+}
+
+size_t mbuf_ring_read(MbufRing *r, void *dst, size_t n) {
+    unsigned char *p = dst;
+    size_t done = 0;
+    while (done < n) {
+        size_t len = 0;
+        const unsigned char *src = mbuf_ring_read_span(r, &len);
+        if (len == 0) {
+            break; // empty
+        }
+        size_t take = (n - done) < len ? (n - done) : len;
+        memcpy(p + done, src, take);
+        mbuf_ring_consume(r, take);
+        done += take;
+    }
+    return done;
+}
+
+// One read(2) into the current write span.
+// returns: bytes read, 0 on EOF, -1 on error (errno = ENOBUFS if the ring is full)
+ssize_t mbuf_ring_read_fd(MbufRing *r, int fd) {
+    size_t len = 0;
+    unsigned char *dst = mbuf_ring_write_span(r, &len);
+    if (len == 0) {
+        errno = ENOBUFS;
+        return -1;
+    }
+    ssize_t got;
+    do {
+        got = read(fd, dst, len);
+    } while (got < 0 && errno == EINTR);
+    if (got > 0) {
+        r->tail += (size_t)got;
+    }
+    return got;
+}
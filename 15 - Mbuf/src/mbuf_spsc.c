@@ -0,0 +1,180 @@
+#define _GNU_SOURCE  // sched_yield
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sched.h>
+#include "mbuf_spsc.h"
+
+// Why this works without locks: with exactly one producer and one consumer,
+// tail is only written by the producer and head only by the consumer.
+// The producer fills slots[tail] and then publishes it with a release store of tail;
+// the consumer's acquire load of tail guarantees it sees the slot contents.
+// Same thing in the other direction for head, which tells the producer a slot is free again.
+//
+// Each side also caches the other side's counter (tail_cache/head_cache) and only
+// re-reads the shared one when the cached value says full/empty. That keeps the two
+// cache lines from bouncing between cores on every operation.
+
+// Spins before we start giving the CPU away while waiting on the other thread
+enum { PIPE_SPINS = 64 };
+
+
+int mbuf_spsc_init(MbufSpsc *q, size_t capacity) {
+    size_t cap = 1;
+    while (cap < capacity) {
+        if (cap > SIZE_MAX / 2) {
+            errno = EINVAL;
+            return -1;
+        }
+        cap <<= 1;
+    }
+    q->slots = calloc(cap, sizeof(*q->slots));
+    if (q->slots == NULL) {
+        errno = ENOMEM;
+        return -1;
+    }
+    q->mask = cap - 1;
+    atomic_init(&q->head, 0);
+    atomic_init(&q->tail, 0);
+    q->tail_cache = 0;
+    q->head_cache = 0;
+    return 0;
+}
+
+void mbuf_spsc_free(MbufSpsc *q) {
+    if (q == NULL) {
+        return;
+    }
+    free(q->slots);
+    q->slots = NULL;
+}
+
+int mbuf_spsc_push(MbufSpsc *q, Mbuf *b) {
+    size_t tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+    if (tail - q->head_cache > q->mask) {
+        // Looks full: refresh our view of how far the consumer got
+        q->head_cache = atomic_load_explicit(&q->head, memory_order_acquire);
+        if (tail - q->head_cache > q->mask) {
+            return -1;
+        }
+    }
+    q->slots[tail & q->mask] = b;
+    atomic_store_explicit(&q->tail, tail + 1, memory_order_release);
+    return 0;
+}
+
+Mbuf *mbuf_spsc_pop(MbufSpsc *q) {
+    size_t head = atomic_load_explicit(&q->head, memory_order_relaxed);
+    if (head == q->tail_cache) {
+        // Looks empty: refresh our view of how far the producer got
+        q->tail_cache = atomic_load_explicit(&q->tail, memory_order_acquire);
+        if (head == q->tail_cache) {
+            return NULL;
+        }
+    }
+    Mbuf *b = q->slots[head & q->mask];
+    atomic_store_explicit(&q->head, head + 1, memory_order_release);
+    return b;
+}
+
+// Spin a little, then yield so we don't starve the other thread on a busy core.
+static void pipe_backoff(unsigned *spins) {
+    if (*spins < PIPE_SPINS) {
+        (*spins)++;
+    } else {
+        sched_yield();
+    }
+}
+
+int mbuf_pipe_init(MbufPipe *p, size_t nblocks, size_t block_capacity) {
+    if (nblocks == 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    p->blocks = calloc(nblocks, sizeof(Mbuf));
+    if (p->blocks == NULL) {
+        errno = ENOMEM;
+        return -1;
+    }
+    p->nblocks = nblocks;
+    atomic_init(&p->closed, 0);
+    if (mbuf_spsc_init(&p->full, nblocks) != 0) {
+        free(p->blocks);
+        return -1;
+    }
+    if (mbuf_spsc_init(&p->free, nblocks) != 0) {
+        mbuf_spsc_free(&p->full);
+        free(p->blocks);
+        return -1;
+    }
+    // Allocate every block up front and park it on the free queue
+    for (size_t i = 0; i < nblocks; i++) {
+        mbuf_init(&p->blocks[i]);
+        if (mbuf_reserve(&p->blocks[i], block_capacity) != 0) {
+            mbuf_pipe_free(p);
+            errno = ENOMEM;
+            return -1;
+        }
+        mbuf_spsc_push(&p->free, &p->blocks[i]);
+    }
+    return 0;
+}
+
+void mbuf_pipe_free(MbufPipe *p) {
+    if (p == NULL || p->blocks == NULL) {
+        return;
+    }
+    for (size_t i = 0; i < p->nblocks; i++) {
+        mbuf_free(&p->blocks[i]);
+    }
+    free(p->blocks);
+    p->blocks = NULL;
+    mbuf_spsc_free(&p->full);
+    mbuf_spsc_free(&p->free);
+}
+
+Mbuf *mbuf_pipe_acquire(MbufPipe *p) {
+    unsigned spins = 0;
+    Mbuf *b;
+    while ((b = mbuf_spsc_pop(&p->free)) == NULL) {
+        pipe_backoff(&spins);
+    }
+    return b;
+}
+
+void mbuf_pipe_submit(MbufPipe *p, Mbuf *b) {
+    unsigned spins = 0;
+    // full has room for every block, so this only waits if the caller made up a block
+    while (mbuf_spsc_push(&p->full, b) != 0) {
+        pipe_backoff(&spins);
+    }
+}
+
+void mbuf_pipe_close(MbufPipe *p) {
+    atomic_store_explicit(&p->closed, 1, memory_order_release);
+}
+
+Mbuf *mbuf_pipe_receive(MbufPipe *p) {
+    unsigned spins = 0;
+    for (;;) {
+        Mbuf *b = mbuf_spsc_pop(&p->full);
+        if (b != NULL) {
+            return b;
+        }
+        if (atomic_load_explicit(&p->closed, memory_order_acquire)) {
+            // Everything submitted before close is visible now; one last look
+            return mbuf_spsc_pop(&p->full);
+        }
+        pipe_backoff(&spins);
+    }
+}
+
+void mbuf_pipe_release(MbufPipe *p, Mbuf *b) {
+    unsigned spins = 0;
+    mbuf_clear(b); // keep the capacity, drop the contents
+    while (mbuf_spsc_push(&p->free, b) != 0) {
+        pipe_backoff(&spins);
+    }
+}
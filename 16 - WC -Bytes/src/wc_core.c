@@ -5,64 +5,209 @@
 #include <string.h>
 #include <ctype.h>  
 #include "wc_core.h"
+#include "wc_simd.h"
 
+// One pass, many metrics.
+// Everything goes through wc_feed, which looks at each byte once and only does the
+// work for the metrics that were asked for:
+//   bytes only        -> just add n (no per-byte loop at all)
+//   lines (+bytes)    -> memchr for '\n'
+//   words and/or lines -> vector kernel picked at runtime (wc_simd.c)
+//   chars             -> vectorized UTF-8 counter/validator (wc_utf8.c)
+//   anything else     -> one byte loop, specialized below for the requested mix
 
 
+// isspace() in the C locale: ' ', \t, \n, \v, \f, \r.
+// A table avoids the function call and the locale lookup per byte.
+static const unsigned char space_table[256] = {
+    ['\t'] = 1, ['\n'] = 1, ['\v'] = 1, ['\f'] = 1, ['\r'] = 1, [' '] = 1,
+};
 
-// Function to read bytes from stdin if no path is provided (i.e argc ==1)
-// *fp = open_stream(path);
-// *out = total bytes read
-int count_bytes(FILE *fp, size_t *out) {
-    unsigned char buffer[4096];
-    size_t total = 0;
-    for (;;) {
-        size_t n = fread(buffer, 1, sizeof(buffer), fp);
-        if (n >0) { 
-            total += n;
-    } else 
+void wc_state_init(struct wc_state *st) {
+    memset(st, 0, sizeof(*st));
+    wc_utf8_init(&st->utf8);
+    wc_uwords_init(&st->uwords);
+}
+
+static size_t count_newlines(const unsigned char *buf, size_t n) {
+    size_t lines = 0;
+    const unsigned char *p = buf;
+    const unsigned char *end = buf + n;
+    while ((p = memchr(p, '\n', (size_t)(end - p))) != NULL) {
+        lines++;
+        p++;
+    }
+    return lines;
+}
+
+// The general byte loop. It is inlined into feed_* wrappers with constant flags,
+// so the compiler drops the branches for metrics nobody asked for.
+static inline __attribute__((always_inline))
+void feed_loop(struct wc_state *st, const unsigned char *buf, size_t n,
+               int want_words, int want_lines, int want_max) {
+    size_t words = st->counts.words;
+    size_t lines = st->counts.lines;
+    size_t max_line = st->counts.max_line;
+    size_t line_len = st->line_len;
+    int in_word = st->in_word;
+
+    for (size_t i = 0; i < n; i++) {
+        unsigned char c = buf[i];
+        if (want_words) {
+            if (space_table[c]) {
+                in_word = 0; // Exiting a word (or still between words)
+            } else if (!in_word) {
+                words++; // Starting a new word
+                in_word = 1;
+            }
+        }
+        if (want_lines || want_max) {
+            if (c == '\n') {
+                if (want_lines) {
+                    lines++;
+                }
+                if (want_max) {
+                    if (line_len > max_line) {
+                        max_line = line_len;
+                    }
+                    line_len = 0;
+                }
+                continue;
+            }
+        }
+        // 10xxxxxx is the middle of a multi-byte UTF-8 sequence, not a new character
+        if (want_max) {
+            line_len += (c & 0xC0) != 0x80;
+        }
+    }
+
+    st->counts.words = words;
+    st->counts.lines = lines;
+    st->counts.max_line = max_line;
+    st->line_len = line_len;
+    st->in_word = in_word;
+}
+
+static void feed_all(struct wc_state *st, const unsigned char *buf, size_t n) {
+    feed_loop(st, buf, n, 1, 1, 1);
+}
+
+static void feed_generic(struct wc_state *st, unsigned flags, const unsigned char *buf, size_t n) {
+    feed_loop(st, buf, n, (flags & WC_WORDS) != 0, (flags & WC_LINES) != 0,
+              (flags & WC_MAXLINE) != 0);
+}
+
+// Count n more bytes of the stream into st.
+// flags: WC_* metrics wanted; metrics not requested are left alone.
+void wc_feed(struct wc_state *st, unsigned flags, const unsigned char *buf, size_t n) {
+    st->counts.bytes += n;
+
+    if (flags & WC_CHARS) {
+        // separate pass over the same (cache-hot) buffer
+        wc_utf8_feed(&st->utf8, buf, n);
+        st->counts.chars = st->utf8.chars;
+    }
+
+    unsigned work = flags & (WC_WORDS | WC_LINES | WC_MAXLINE);
+    if ((flags & WC_USPACE) && (flags & WC_WORDS)) {
+        // Unicode-aware words (lines come along for free)
+        size_t unused_lines = 0;
+        wc_uwords_feed(&st->uwords, buf, n, &st->in_word, &st->counts.words,
+                       (flags & WC_LINES) ? &st->counts.lines : &unused_lines);
+        work &= ~(unsigned)(WC_WORDS | WC_LINES);
+    }
+
+    switch (work) {
+    case 0:
+        break; // bytes/chars only
+    case WC_LINES:
+        st->counts.lines += count_newlines(buf, n);
+        break;
+    case WC_WORDS: {
+        size_t unused_lines = 0;
+        wc_kernel()(buf, n, &st->in_word, &st->counts.words, &unused_lines);
         break;
     }
-    if (ferror(fp)) {
-        fprintf(stderr, "fread failed: %s\n", strerror(errno));        
-        return -1;
+    case WC_WORDS | WC_LINES:
+        wc_kernel()(buf, n, &st->in_word, &st->counts.words, &st->counts.lines);
+        break;
+    case WC_WORDS | WC_LINES | WC_MAXLINE:
+        feed_all(st, buf, n);
+        break;
+    default:
+        feed_generic(st, work, buf, n);
+        break;
     }
-    *out = total;
-    return 0;
 }
 
-// fp : file pointer to read from
-// out: pointer to size_t to store word count else we return -1 on error which is checked by caller 
+// End of input: a UTF-8 sequence that never finished is invalid (and, for
+// Unicode words, one last non-space character).
+void wc_state_finish(struct wc_state *st, unsigned flags) {
+    if (flags & WC_CHARS) {
+        wc_utf8_finish(&st->utf8);
+    }
+    if ((flags & WC_USPACE) && (flags & WC_WORDS)) {
+        wc_uwords_finish(&st->uwords, &st->in_word, &st->counts.words);
+    }
+}
 
-int count_words(FILE *fp, size_t *out) {
-    unsigned char buffer[4096];
-    size_t total_words = 0;
-    int in_word = 0; // Flag to track if we are inside a word
+// Snapshot of the counts for everything fed so far.
+void wc_state_counts(const struct wc_state *st, struct wc_counts *out) {
+    *out = st->counts;
+    out->invalid_at = st->utf8.first_invalid;
+    // A last line without a trailing '\n' still counts toward the longest line
+    if (st->line_len > out->max_line) {
+        out->max_line = st->line_len;
+    }
+}
 
-    for(;;) {
+// Read fp to EOF and compute the requested metrics in a single pass.
+// fp: stream to read
+// flags: WC_* metrics wanted
+// out: filled on success
+// returns: 0 on success, -1 on read error (errno set, nothing printed)
+int wc_count_stream(FILE *fp, unsigned flags, struct wc_counts *out) {
+    unsigned char buffer[64 * 1024];
+    struct wc_state st;
+    wc_state_init(&st);
+
+    for (;;) {
         size_t n = fread(buffer, 1, sizeof(buffer), fp);
-        if (n ==0) {
+        if (n == 0) {
             if (ferror(fp)) {
-                fprintf(stderr, "fread failed: %s\n", strerror(errno));
-                return -1;
+                return -1; // errno from the failed read; the caller reports it
             }
             break; // EOF reached
         }
-        for (size_t i = 0; i < n; i++) {
-            if (isspace(buffer[i]) && in_word== 1) {
-                    in_word = 0; // Exiting a word
-                } else {
-                    // Still outside a word
-                    if (in_word==0) {
-                        total_words++; // Starting a new word
-                        in_word = 1;
-                    }
-                }
-            }
-        
+        wc_feed(&st, flags, buffer, n);
     }
-    *out = total_words;
+
+    wc_state_finish(&st, flags);
+    wc_state_counts(&st, out);
     return 0;
 }
 
 
+// Function to read bytes from stdin if no path is provided (i.e argc ==1)
+// *fp = open_stream(path);
+// *out = total bytes read
+int count_bytes(FILE *fp, size_t *out) {
+    struct wc_counts c;
+    if (wc_count_stream(fp, WC_BYTES, &c) != 0) {
+        return -1;
+    }
+    *out = c.bytes;
+    return 0;
+}
 
+// fp : file pointer to read from
+// out: pointer to size_t to store word count else we return -1 on error which is checked by caller 
+// A word is a run of non-whitespace bytes.
+int count_words(FILE *fp, size_t *out) {
+    struct wc_counts c;
+    if (wc_count_stream(fp, WC_WORDS, &c) != 0) {
+        return -1;
+    }
+    *out = c.words;
+    return 0;
+}
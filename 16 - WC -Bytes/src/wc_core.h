@@ -1,6 +1,41 @@
 #pragma once
 #include <stdio.h>
 #include <stddef.h>
+#include "wc_utf8.h"
+
+// Metrics the counting engine can produce; OR them together.
+enum {
+    WC_BYTES   = 1 << 0,
+    WC_WORDS   = 1 << 1,
+    WC_LINES   = 1 << 2,
+    WC_CHARS   = 1 << 3,   // UTF-8 characters (bytes that aren't 10xxxxxx continuation bytes), validated
+    WC_MAXLINE = 1 << 4,   // longest line in characters, not counting the '\n'
+    WC_USPACE  = 1 << 5,   // not a metric: words are also split on Unicode whitespace
+};
+
+struct wc_counts {
+    size_t bytes;
+    size_t words;
+    size_t lines;
+    size_t chars;
+    size_t max_line;
+    size_t invalid_at;  // WC_CHARS: offset of the first invalid UTF-8 sequence, WC_UTF8_OK if none
+};
+
+// Running state so a stream can be fed in pieces; where the pieces split doesn't matter.
+struct wc_state {
+    struct wc_counts counts;
+    int in_word;        // last byte seen was part of a word
+    size_t line_len;    // characters in the current (unfinished) line
+    struct wc_utf8 utf8;     // WC_CHARS counter/validator
+    struct wc_uwords uwords; // WC_USPACE decoder
+};
+
+void wc_state_init(struct wc_state *st);
+void wc_feed(struct wc_state *st, unsigned flags, const unsigned char *buf, size_t n);
+void wc_state_counts(const struct wc_state *st, struct wc_counts *out); // counts so far, open line included
+void wc_state_finish(struct wc_state *st, unsigned flags); // end of input: close open UTF-8 sequences
+int wc_count_stream(FILE *fp, unsigned flags, struct wc_counts *out);
 
 int count_bytes(FILE *fp, size_t *out);
 // static FILE* open_stream(const char *path);
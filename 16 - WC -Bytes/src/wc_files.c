@@ -0,0 +1,265 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "wc_files.h"
+#include "wc_parallel.h"
+#include "wc_simd.h"
+
+// Many files, one process.
+// Worker threads pull the next file index from a shared counter and store their result
+// in results[index]. The calling thread walks the results in order and emits each one as
+// soon as it's done, so output order always matches the argument order no matter which
+// file finishes first.
+// "-" operands are the exception: they all share one stdin, so the calling thread counts
+// them itself, in order. The first one reads to EOF and any later ones count 0.
+
+struct file_pool {
+    const char *const *paths;
+    size_t n;
+    unsigned flags;
+    struct wc_file_result *results;
+    unsigned char *done;        // done[i] set once results[i] is filled in
+    size_t next;                // next index to hand out
+    pthread_mutex_t lock;
+    pthread_cond_t finished;    // signalled whenever a file completes
+};
+
+
+static int is_stdin(const char *path) {
+    return !path || strcmp(path, "-") == 0;
+}
+
+// Function to open a file stream for reading bytes from a specified path
+static FILE *open_stream(const char *path, int *need_close) {
+    if (is_stdin(path)) {
+        *need_close = 0;
+        return stdin;
+    }
+    FILE *fp = fopen(path, "rb");          // 'rb' keeps counts exact on Windows
+    *need_close = (fp != NULL);
+    return fp;
+}
+
+int wc_count_path(const char *path, unsigned flags, int jobs, struct wc_counts *out) {
+    int need_close = 0;
+    FILE *fp = open_stream(path, &need_close);
+    if (fp == NULL) {
+        return -1;
+    }
+
+    int rc = -1;
+    struct stat sb;
+    int fd = fileno(fp);
+    int regular = (fstat(fd, &sb) == 0 && S_ISREG(sb.st_mode));
+    // where reading would start: not 0 for a stdin that was partly read before us
+    off_t pos = regular ? lseek(fd, 0, SEEK_CUR) : 0;
+    size_t left = (pos >= 0 && pos < sb.st_size) ? (size_t)(sb.st_size - pos) : 0;
+
+    if (regular && pos >= 0 && flags == WC_BYTES) {
+        // Byte count of a regular file is its size past the read position; no need to read it
+        memset(out, 0, sizeof(*out));
+        out->bytes = left;
+        out->invalid_at = WC_UTF8_OK;
+        lseek(fd, 0, SEEK_END);
+        rc = 0;
+    } else if (regular && pos >= 0 && jobs > 1 && left >= WC_PARALLEL_MIN_SIZE &&
+               wc_count_mapped(fd, (size_t)pos, left, flags, jobs, out) == 0) {
+        lseek(fd, 0, SEEK_END); // as if we had read it, for a later "-" or the parent shell
+        rc = 0;
+    } else {
+        // pipes, terminals, small files, or mmap failed
+        rc = wc_count_stream(fp, flags, out);
+    }
+
+    int saved = errno;
+    if (need_close) {
+        fclose(fp);
+    }
+    errno = saved;
+    return rc;
+}
+
+static void *file_worker(void *arg) {
+    struct file_pool *pool = arg;
+    for (;;) {
+        pthread_mutex_lock(&pool->lock);
+        size_t i = pool->next++;
+        pthread_mutex_unlock(&pool->lock);
+        if (i >= pool->n) {
+            break;
+        }
+        if (is_stdin(pool->paths[i])) {
+            continue; // counted by the calling thread
+        }
+
+        struct wc_file_result res;
+        memset(&res, 0, sizeof(res));
+        // the pool already keeps every thread busy, so each file is counted single-threaded
+        res.rc = wc_count_path(pool->paths[i], pool->flags, 1, &res.counts);
+        res.err = res.rc ? errno : 0;
+
+        pthread_mutex_lock(&pool->lock);
+        pool->results[i] = res;
+        pool->done[i] = 1;
+        pthread_cond_broadcast(&pool->finished);
+        pthread_mutex_unlock(&pool->lock);
+    }
+    return NULL;
+}
+
+int wc_count_files(const char *const *paths, size_t n, unsigned flags, int jobs,
+                   wc_emit_fn emit, void *ctx) {
+    int status = 0;
+    if (n == 0) {
+        return 0;
+    }
+    if (n == 1) {
+        // One file gets all the threads for itself
+        struct wc_file_result res;
+        memset(&res, 0, sizeof(res));
+        res.rc = wc_count_path(paths[0], flags, jobs, &res.counts);
+        res.err = res.rc ? errno : 0;
+        emit(0, &res, ctx);
+        return res.rc;
+    }
+
+    struct file_pool pool;
+    pool.paths = paths;
+    pool.n = n;
+    pool.flags = flags;
+    pool.next = 0;
+    pool.results = calloc(n, sizeof(*pool.results));
+    pool.done = calloc(n, 1);
+    if (pool.results == NULL || pool.done == NULL) {
+        free(pool.results);
+        free(pool.done);
+        errno = ENOMEM;
+        return -1;
+    }
+    pthread_mutex_init(&pool.lock, NULL);
+    pthread_cond_init(&pool.finished, NULL);
+
+    wc_kernel(); // pick the SIMD kernel before the workers race to do it
+
+    size_t workers = (jobs < 1) ? 1 : (size_t)jobs;
+    if (workers > n) {
+        workers = n;
+    }
+    pthread_t *tid = calloc(workers, sizeof(*tid));
+    size_t started = 0;
+    if (tid != NULL) {
+        while (started < workers && pthread_create(&tid[started], NULL, file_worker, &pool) == 0) {
+            started++;
+        }
+    }
+    if (started == 0) {
+        file_worker(&pool); // no threads at all: do the work here, emit below
+    }
+
+    // Emit in order as results arrive
+    for (size_t i = 0; i < n; i++) {
+        struct wc_file_result res;
+        if (is_stdin(paths[i])) {
+            memset(&res, 0, sizeof(res));
+            res.rc = wc_count_path(paths[i], flags, 1, &res.counts);
+            res.err = res.rc ? errno : 0;
+        } else {
+            pthread_mutex_lock(&pool.lock);
+            while (!pool.done[i]) {
+                pthread_cond_wait(&pool.finished, &pool.lock);
+            }
+            res = pool.results[i];
+            pthread_mutex_unlock(&pool.lock);
+        }
+
+        if (res.rc != 0) {
+            status = -1;
+        }
+        emit(i, &res, ctx);
+    }
+
+    for (size_t t = 0; t < started; t++) {
+        pthread_join(tid[t], NULL);
+    }
+    free(tid);
+    pthread_cond_destroy(&pool.finished);
+    pthread_mutex_destroy(&pool.lock);
+    free(pool.results);
+    free(pool.done);
+    return status;
+}
+
+char **wc_read_names0(const char *path, size_t *count) {
+    int need_close = 0;
+    FILE *fp = open_stream(path, &need_close);
+    if (fp == NULL) {
+        return NULL;
+    }
+
+    char **names = NULL;
+    size_t n = 0, cap = 0;
+    char *line = NULL;
+    size_t line_cap = 0;
+    ssize_t len;
+    while ((len = getdelim(&line, &line_cap, '\0', fp)) != -1) {
+        if (len > 0 && line[len - 1] == '\0') {
+            len--;
+        }
+        if (len == 0) {
+            continue; // skip empty names
+        }
+        if (n == cap) {
+            size_t new_cap = cap ? cap * 2 : 64;
+            char **grown = realloc(names, new_cap * sizeof(*names));
+            if (grown == NULL) {
+                goto fail;
+            }
+            names = grown;
+            cap = new_cap;
+        }
+        names[n] = malloc((size_t)len + 1);
+        if (names[n] == NULL) {
+            goto fail;
+        }
+        memcpy(names[n], line, (size_t)len);
+        names[n][len] = '\0';
+        n++;
+    }
+    if (ferror(fp)) {
+        goto fail;
+    }
+    free(line);
+    if (need_close) {
+        fclose(fp);
+    }
+    *count = n;
+    return names != NULL ? names : calloc(1, sizeof(*names));
+
+fail:
+    {
+        int saved = errno;
+        free(line);
+        wc_free_names(names, n);
+        if (need_close) {
+            fclose(fp);
+        }
+        errno = saved ? saved : ENOMEM;
+        return NULL;
+    }
+}
+
+void wc_free_names(char **names, size_t count) {
+    if (names == NULL) {
+        return;
+    }
+    for (size_t i = 0; i < count; i++) {
+        free(names[i]);
+    }
+    free(names);
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include <stddef.h>
+#include "wc_core.h"
+
+struct wc_file_result {
+    struct wc_counts counts;
+    int rc;     // 0 ok, -1 failed
+    int err;    // errno when rc == -1
+};
+
+// Called on the calling thread, once per file, in argument order.
+typedef void (*wc_emit_fn)(size_t index, const struct wc_file_result *res, void *ctx);
+
+// Count one path ("-" = stdin). Big regular files use jobs threads (see wc_parallel.h);
+// with flags == WC_BYTES a regular file's size comes straight from fstat.
+int wc_count_path(const char *path, unsigned flags, int jobs, struct wc_counts *out);
+
+// Count n paths on a pool of at most jobs threads and hand the results to emit in order.
+// returns: 0 if every file was counted, -1 if any failed
+int wc_count_files(const char *const *paths, size_t n, unsigned flags, int jobs,
+                   wc_emit_fn emit, void *ctx);
+
+// Read a NUL-separated list of names (as from `find -print0`). path "-" = stdin.
+// returns: malloc'd array (free with wc_free_names), *count set; NULL on error
+char **wc_read_names0(const char *path, size_t *count);
+void wc_free_names(char **names, size_t count);
@@ -0,0 +1,205 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif
+#include "wc_follow.h"
+
+// Follow mode for append-only logs.
+// The wc_state from the first pass (counts, in_word, open line length) is kept, and
+// from then on we only read bytes past the last offset we counted:
+//
+//   inotify says "modified" -> read(2) from our offset to EOF, wc_feed it
+//   size < our offset       -> truncated: reset the state, count from 0 again
+//   path has a new inode    -> rotated: drain the old file, then start on the new one
+//
+// Without inotify (other systems, or out of watches) the same checks just run on a timer.
+
+static volatile sig_atomic_t stop_requested;
+
+static void on_signal(int sig) {
+    (void)sig;
+    stop_requested = 1;
+}
+
+struct follower {
+    const char *path;
+    unsigned flags;
+    int fd;
+    off_t offset;          // bytes of the current file already counted
+    struct wc_state st;
+    int ino_fd;            // inotify instance, -1 if unavailable
+    int watch;             // watch descriptor on the current file
+    int changed;           // counts moved since the last report
+};
+
+static long now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static void watch_current(struct follower *f) {
+#ifdef __linux__
+    if (f->ino_fd < 0) {
+        return;
+    }
+    if (f->watch >= 0) {
+        inotify_rm_watch(f->ino_fd, f->watch); // fails harmlessly if the file is gone
+    }
+    f->watch = inotify_add_watch(f->ino_fd, f->path,
+                                 IN_MODIFY | IN_ATTRIB | IN_MOVE_SELF | IN_DELETE_SELF);
+#else
+    (void)f;
+#endif
+}
+
+// Read everything between our offset and EOF into the state.
+static int drain(struct follower *f) {
+    unsigned char buffer[64 * 1024];
+    for (;;) {
+        ssize_t n = pread(f->fd, buffer, sizeof(buffer), f->offset);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            fprintf(stderr, "read %s: %s\n", f->path, strerror(errno));
+            return -1;
+        }
+        if (n == 0) {
+            return 0;
+        }
+        wc_feed(&f->st, f->flags, buffer, (size_t)n);
+        f->offset += n;
+        f->changed = 1;
+    }
+}
+
+// Truncated in place: what we counted is gone, start over
+static int check_truncated(struct follower *f) {
+    struct stat sb;
+    if (fstat(f->fd, &sb) == 0 && S_ISREG(sb.st_mode) && sb.st_size < f->offset) {
+        wc_state_init(&f->st);
+        f->offset = 0;
+        f->changed = 1;
+    }
+    return drain(f);
+}
+
+// Rotated: the path now names a different file than the one we have open
+static int check_rotated(struct follower *f) {
+    struct stat cur, named;
+    if (stat(f->path, &named) != 0) {
+        return 0; // moved away and not recreated yet; keep reading the old one
+    }
+    if (fstat(f->fd, &cur) != 0 || (cur.st_ino == named.st_ino && cur.st_dev == named.st_dev)) {
+        return 0;
+    }
+    if (drain(f) != 0) { // finish whatever was written to the old file
+        return -1;
+    }
+    int fd = open(f->path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return 0; // raced with another rotation; try again next time
+    }
+    close(f->fd);
+    f->fd = fd;
+    f->offset = 0;
+    wc_state_init(&f->st);
+    f->changed = 1;
+    watch_current(f);
+    return drain(f);
+}
+
+// Throw away queued inotify events; we only use them as a wake-up
+static void discard_events(struct follower *f) {
+#ifdef __linux__
+    char buf[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    while (read(f->ino_fd, buf, sizeof(buf)) > 0) {
+    }
+#else
+    (void)f;
+#endif
+}
+
+int wc_follow(const char *path, unsigned flags, int interval_ms, wc_follow_fn report, void *ctx) {
+    struct follower f;
+    memset(&f, 0, sizeof(f));
+    f.path = path;
+    f.flags = flags;
+    f.ino_fd = -1;
+    f.watch = -1;
+    wc_state_init(&f.st);
+
+    f.fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (f.fd < 0) {
+        fprintf(stderr, "open %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+#ifdef __linux__
+    f.ino_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#endif
+    watch_current(&f);
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_signal;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    int rc = drain(&f);
+    struct wc_counts counts;
+    wc_state_counts(&f.st, &counts);
+    report(&counts, ctx);
+    f.changed = 0;
+
+    long next_report = now_ms() + interval_ms;
+    while (rc == 0 && !stop_requested) {
+        long wait = next_report - now_ms();
+        if (wait < 0) {
+            wait = 0;
+        }
+        struct pollfd pfd = { f.ino_fd, POLLIN, 0 };
+        int ready = poll(&pfd, f.ino_fd >= 0 ? 1 : 0, (int)wait);
+        if (ready < 0 && errno != EINTR) {
+            perror("poll");
+            rc = -1;
+            break;
+        }
+        if (ready > 0) {
+            discard_events(&f);
+        }
+        if (check_truncated(&f) != 0 || check_rotated(&f) != 0) {
+            rc = -1;
+            break;
+        }
+        if (now_ms() >= next_report) {
+            if (f.changed) {
+                wc_state_counts(&f.st, &counts);
+                report(&counts, ctx);
+                f.changed = 0;
+            }
+            next_report = now_ms() + interval_ms;
+        }
+    }
+
+    if (f.changed) {
+        wc_state_counts(&f.st, &counts);
+        report(&counts, ctx);
+    }
+    if (f.ino_fd >= 0) {
+        close(f.ino_fd);
+    }
+    close(f.fd);
+    return rc;
+}
@@ -0,0 +1,12 @@
+#pragma once
+#include "wc_core.h"
+
+// Called with the current totals every time they are printed.
+typedef void (*wc_follow_fn)(const struct wc_counts *counts, void *ctx);
+
+// Count path, then keep watching it and count only what gets appended.
+// Truncation restarts the counts from the new contents; if the path is rotated
+// (renamed away and recreated) we finish the old file and switch to the new one.
+// interval_ms: how often changed counts are reported
+// returns: 0 when stopped by SIGINT/SIGTERM (after a final report), -1 on error
+int wc_follow(const char *path, unsigned flags, int interval_ms, wc_follow_fn report, void *ctx);
@@ -1,77 +1,223 @@
+// Build (from the project directory): gcc -std=c17 -Wall -Wextra -O2 -pthread src/*.c -o wcmini
+// Test:  sh tests/integ_cli.sh
+#define _POSIX_C_SOURCE 200809L
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <errno.h>
+#include <unistd.h>
 #include "wc_core.h"
-
-// Function to open a file stream for reading bytes from a specified path
-static FILE *open_stream(const char *path, int *need_close) {
-    if (!path || strcmp(path, "-") == 0) {
-        *need_close = 0;
-        return stdin;
-    }
-    FILE *fp = fopen(path, "rb");          // 'rb' keeps counts exact on Windows
-    if (!fp) fprintf(stderr, "open %s: %s\n", path, strerror(errno));
-    *need_close = (fp != NULL);
-    return fp;
-}
+#include "wc_files.h"
+#include "wc_follow.h"
 
 // Function to display usage information
 // p: program name
 static void usage(const char *p) {
     fprintf(stderr,
-        "Usage: %s [--bytes|--words] [file|-]\n"
-        "  --bytes   count bytes (default)\n"
-        "  --words   count words\n"
-        "  file      path to input file; use '-' or omit for stdin\n",
-        p);
+        "Usage: %s [--bytes] [--words] [--lines] [--chars] [--max-line-length] [file|-]...\n"
+        "       %s [options] --files0-from F\n"
+        "       %s [options] --follow [--interval SECS] file\n"
+        "  -c, --bytes            count bytes (default)\n"
+        "  -w, --words            count words\n"
+        "  -l, --lines            count newlines\n"
+        "  -m, --chars            count UTF-8 characters and report the first invalid sequence\n"
+        "  -L, --max-line-length  length of the longest line, in characters\n"
+        "  --unicode-spaces       words are also separated by Unicode whitespace (U+00A0, U+3000, ...)\n"
+        "  -j, --jobs N           worker threads (default: all CPUs)\n"
+        "  --files0-from F        read NUL-separated file names from F ('-' = stdin)\n"
+        "  --follow               keep watching file and count only appended bytes\n"
+        "  --interval SECS        how often --follow prints updated counts (default 1)\n"
+        "  file      path to input file; use '-' or omit for stdin\n"
+        "Any combination can be given; each file is read once. With more than one\n"
+        "metric the counts are printed in the order lines, words, chars, bytes, max-line.\n"
+        "With several files each line ends in the file name, followed by a total line.\n",
+        p, p, p);
 }
 
+// Map one command-line flag to its WC_* bit, 0 if it isn't a metric (or metric modifier) flag
+static unsigned flag_for(const char *arg) {
+    if (strcmp(arg, "--bytes") == 0 || strcmp(arg, "-c") == 0) return WC_BYTES;
+    if (strcmp(arg, "--words") == 0 || strcmp(arg, "-w") == 0) return WC_WORDS;
+    if (strcmp(arg, "--lines") == 0 || strcmp(arg, "-l") == 0) return WC_LINES;
+    if (strcmp(arg, "--chars") == 0 || strcmp(arg, "-m") == 0) return WC_CHARS;
+    if (strcmp(arg, "--max-line-length") == 0 || strcmp(arg, "-L") == 0) return WC_MAXLINE;
+    if (strcmp(arg, "--unicode-spaces") == 0) return WC_USPACE;
+    return 0;
+}
 
-int main(int argc, char **argv) {
-    // designate between bytes/words count based on argv[1] name
-    enum { MODE_BYTES, MODE_WORDS } mode = MODE_BYTES;
-    const char *path = NULL;
+// Parse the -j value; returns 0 for anything that isn't a positive number
+static int parse_jobs(const char *s) {
+    char *end = NULL;
+    long v = strtol(s, &end, 10);
+    if (end == s || *end != '\0' || v < 1 || v > 4096) {
+        return 0;
+    }
+    return (int)v;
+}
 
-    if (argc < 2 || argc > 3) {
-        usage(argv[0]);
-        return 2;
+// Print the requested counts on one line, in wc's column order
+// name: appended after the counts (NULL = bare counts, the single-file format)
+static void print_counts(const struct wc_counts *c, unsigned flags, const char *name) {
+    const char *sep = "";
+    if (flags & WC_LINES)   { printf("%s%zu", sep, c->lines);    sep = " "; }
+    if (flags & WC_WORDS)   { printf("%s%zu", sep, c->words);    sep = " "; }
+    if (flags & WC_CHARS)   { printf("%s%zu", sep, c->chars);    sep = " "; }
+    if (flags & WC_BYTES)   { printf("%s%zu", sep, c->bytes);    sep = " "; }
+    if (flags & WC_MAXLINE) { printf("%s%zu", sep, c->max_line); sep = " "; }
+    if (name) {
+        printf("%s%s", sep, name);
+    }
+    putchar('\n');
+}
+
+// Parse --interval seconds into milliseconds; returns -1 if invalid
+static int parse_interval_ms(const char *s) {
+    char *end = NULL;
+    double secs = strtod(s, &end);
+    if (end == s || *end != '\0' || !(secs > 0.0) || secs > 86400.0) {
+        return -1;
+    }
+    int ms = (int)(secs * 1000.0);
+    return ms > 0 ? ms : 1;
+}
+
+static void print_follow(const struct wc_counts *counts, void *ctx) {
+    print_counts(counts, *(const unsigned *)ctx, NULL);
+    fflush(stdout); // whoever is watching wants it now, not when the buffer fills
+}
+
+// State shared with emit_result while files are reported
+struct report {
+    const char *const *paths;
+    unsigned flags;
+    int show_names;             // more than one file: "counts name" lines and a total
+    struct wc_counts total;
+};
+
+static void emit_result(size_t index, const struct wc_file_result *res, void *ctx) {
+    struct report *rep = ctx;
+    const char *path = rep->paths[index];
+    if (res->rc != 0) {
+        fflush(stdout); // keep the error next to its neighbours when both go to a terminal/file
+        fprintf(stderr, "%s: %s\n", path ? path : "-", strerror(res->err));
+        return;
+    }
+    rep->total.bytes += res->counts.bytes;
+    rep->total.words += res->counts.words;
+    rep->total.lines += res->counts.lines;
+    rep->total.chars += res->counts.chars;
+    if (res->counts.max_line > rep->total.max_line) {
+        rep->total.max_line = res->counts.max_line;
+    }
+    print_counts(&res->counts, rep->flags, rep->show_names ? path : NULL);
+    if ((rep->flags & WC_CHARS) && res->counts.invalid_at != WC_UTF8_OK) {
+        fflush(stdout);
+        fprintf(stderr, "%s: invalid UTF-8 at byte offset %zu\n",
+                path ? path : "-", res->counts.invalid_at);
     }
-    // very small arg parser: [--bytes | --words] [file]
+}
+
+
+int main(int argc, char **argv) {
+    // collect the requested metrics from the flags; no flags means bytes
+    unsigned flags = 0;
+    const char *files0_from = NULL;
+    int follow = 0;
+    int interval_ms = 1000;
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int jobs = cpus > 0 ? (int)cpus : 1;
+
+    // file operands are collected in place at the front of argv
+    const char **paths = (const char **)argv + 1;
+    size_t npaths = 0;
+
+    // very small arg parser: [metric flags...] [file...]
     for (int i = 1; i <argc; i++) {
-        if (strcmp(argv[i], "--bytes") == 0 ) {
-            mode = MODE_BYTES;
-        } else if (strcmp(argv[i], "--words") == 0) {
-            mode = MODE_WORDS;
-        } else if (path == NULL) {
-            path = argv[i];
+        unsigned f = flag_for(argv[i]);
+        if (f != 0) {
+            flags |= f;
+        } else if (strcmp(argv[i], "-j") == 0 || strcmp(argv[i], "--jobs") == 0) {
+            if (i + 1 >= argc || (jobs = parse_jobs(argv[i + 1])) == 0) {
+                usage(argv[0]);
+                return 2;
+            }
+            i++;
+        } else if (strncmp(argv[i], "-j", 2) == 0 && argv[i][2] != '\0') {
+            if ((jobs = parse_jobs(argv[i] + 2)) == 0) { // -j8
+                usage(argv[0]);
+                return 2;
+            }
+        } else if (strcmp(argv[i], "--files0-from") == 0) {
+            if (i + 1 >= argc) {
+                usage(argv[0]);
+                return 2;
+            }
+            files0_from = argv[++i];
+        } else if (strncmp(argv[i], "--files0-from=", 14) == 0) {
+            files0_from = argv[i] + 14;
+        } else if (strcmp(argv[i], "--follow") == 0) {
+            follow = 1;
+        } else if (strcmp(argv[i], "--interval") == 0) {
+            if (i + 1 >= argc || (interval_ms = parse_interval_ms(argv[i + 1])) < 0) {
+                usage(argv[0]);
+                return 2;
+            }
+            i++;
+        } else if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
+            usage(argv[0]);
+            return 0;
+        } else if (argv[i][0] != '-' || strcmp(argv[i], "-") == 0) {
+            paths[npaths++] = argv[i];
         } else {
             usage(argv[0]);
             return 2;
         }
     }
-    int need_close = 0;
-    FILE *fp = open_stream(path, &need_close);
-    if (fp == NULL) {
-        return 1;       
+    if ((flags & ~(unsigned)WC_USPACE) == 0) {
+        flags |= WC_BYTES;
+    }
+
+    if (follow) {
+        if (npaths != 1 || files0_from != NULL || strcmp(paths[0], "-") == 0) {
+            fprintf(stderr, "%s: --follow needs exactly one file path\n", argv[0]);
+            return 2;
+        }
+        return wc_follow(paths[0], flags, interval_ms, print_follow, &flags) == 0 ? 0 : 1;
     }
 
-    size_t out = 0;
-    int rc = 0;
-    if (mode == MODE_BYTES) {
-        rc = count_bytes(fp, &out);
-    } else {
-        rc = count_words(fp, &out);
+    char **names0 = NULL;
+    size_t nnames0 = 0;
+    if (files0_from != NULL) {
+        if (npaths > 0) {
+            fprintf(stderr, "%s: file operands cannot be combined with --files0-from\n", argv[0]);
+            return 2;
+        }
+        names0 = wc_read_names0(files0_from, &nnames0);
+        if (names0 == NULL) {
+            fprintf(stderr, "%s: %s\n", files0_from, strerror(errno));
+            return 1;
+        }
+        paths = (const char **)names0;
+        npaths = nnames0;
     }
 
-    if (need_close) {
-        fclose(fp);     
+    static const char *stdin_only[] = { "-" };
+    if (npaths == 0 && files0_from == NULL) {
+        paths = stdin_only; // no operands: count stdin
+        npaths = 1;
     }
-    if (rc == -1) {
-        perror("Error during counting");
-        return 1;
-    } else {
-        printf("%zu\n", out);
+
+    struct report rep;
+    memset(&rep, 0, sizeof(rep));
+    rep.paths = paths;
+    rep.flags = flags;
+    rep.show_names = (npaths > 1 || files0_from != NULL);
+
+    int rc = wc_count_files(paths, npaths, flags, jobs, emit_result, &rep);
+    if (npaths > 1) {
+        print_counts(&rep.total, flags, "total");
     }
 
-    return 0;
-}
\ No newline at end of file
+    wc_free_names(names0, nnames0);
+    return rc == 0 ? 0 : 1;
+}
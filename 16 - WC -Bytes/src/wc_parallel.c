@@ -0,0 +1,175 @@
+#define _DEFAULT_SOURCE  // madvise
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "wc_parallel.h"
+#include "wc_simd.h"
+
+// Parallel counting of a regular file:
+//
+//   [ chunk 0 | chunk 1 | chunk 2 | chunk 3 ]     one thread per chunk, each with a fresh wc_state
+//
+// Bytes, lines and chars just add up. Two things can straddle a boundary:
+//   - a word: chunk k ends inside a word and chunk k+1 starts with a non-space byte.
+//     Both chunks counted it, so the merge subtracts one.
+//   - a line (for --max-line-length): the first line of chunk k+1 continues the last
+//     line of chunk k. Each chunk reports the length of its leading partial line and
+//     its trailing partial line, and the merge stitches them back together.
+//
+// For --chars and Unicode words, boundaries are also nudged forward past continuation
+// bytes so no chunk starts in the middle of a UTF-8 sequence.
+
+struct chunk_job {
+    const unsigned char *buf;
+    size_t start;           // offset of buf in the file
+    size_t len;
+    unsigned flags;
+    struct wc_state st;     // counts for this chunk alone
+    size_t head_len;        // characters before the first '\n' (whole chunk if none)
+    int has_newline;
+    int threaded;           // ran on its own thread (needs a join)
+};
+
+static const unsigned char space_table[256] = {
+    ['\t'] = 1, ['\n'] = 1, ['\v'] = 1, ['\f'] = 1, ['\r'] = 1, [' '] = 1,
+};
+
+static size_t count_chars(const unsigned char *p, size_t n) {
+    size_t chars = 0;
+    for (size_t i = 0; i < n; i++) {
+        chars += (p[i] & 0xC0) != 0x80;
+    }
+    return chars;
+}
+
+static void *count_chunk(void *arg) {
+    struct chunk_job *job = arg;
+    wc_state_init(&job->st);
+    wc_feed(&job->st, job->flags, job->buf, job->len);
+    wc_state_finish(&job->st, job->flags);
+
+    if (job->flags & WC_MAXLINE) {
+        const unsigned char *nl = memchr(job->buf, '\n', job->len);
+        job->has_newline = (nl != NULL);
+        job->head_len = count_chars(job->buf, nl ? (size_t)(nl - job->buf) : job->len);
+    }
+    return NULL;
+}
+
+int wc_count_mapped(int fd, size_t offset, size_t size, unsigned flags, int jobs,
+                    struct wc_counts *out) {
+    memset(out, 0, sizeof(*out));
+    out->invalid_at = WC_UTF8_OK;
+    if (size == 0) {
+        return 0;
+    }
+    // mmap offsets must be page aligned, so map from the page `offset` is in
+    size_t skip = offset % (size_t)sysconf(_SC_PAGESIZE);
+    unsigned char *base = mmap(NULL, skip + size, PROT_READ, MAP_PRIVATE, fd, (off_t)(offset - skip));
+    if (base == MAP_FAILED) {
+        return -1;
+    }
+    unsigned char *map = base + skip;
+    madvise(base, skip + size, MADV_SEQUENTIAL);
+
+    if (jobs < 1) {
+        jobs = 1;
+    }
+    if ((size_t)jobs > size) {
+        jobs = (int)size;
+    }
+    struct chunk_job *job = calloc((size_t)jobs, sizeof(*job));
+    pthread_t *tid = calloc((size_t)jobs, sizeof(*tid));
+    if (job == NULL || tid == NULL) {
+        free(job);
+        free(tid);
+        munmap(base, skip + size);
+        errno = ENOMEM;
+        return -1;
+    }
+
+    wc_kernel(); // pick the SIMD kernel before the threads race to do it
+
+    size_t step = size / (size_t)jobs;
+    int utf8 = (flags & (WC_CHARS | WC_USPACE)) != 0;
+    size_t start = 0;
+    for (int k = 0; k < jobs; k++) {
+        size_t end = (k == jobs - 1) ? size : (size_t)(k + 1) * step;
+        if (end < start) {
+            end = start;
+        }
+        // don't split a UTF-8 sequence (a valid one has at most 3 continuation bytes)
+        for (int extra = 0; utf8 && extra < 3 && end < size && (map[end] & 0xC0) == 0x80; extra++) {
+            end++;
+        }
+        job[k].buf = map + start;
+        job[k].start = start;
+        job[k].len = end - start;
+        job[k].flags = flags;
+        start = end;
+    }
+    // Chunk 0 runs on this thread; if a thread can't be created, run its chunk here too
+    for (int k = 1; k < jobs; k++) {
+        job[k].threaded = (pthread_create(&tid[k], NULL, count_chunk, &job[k]) == 0);
+    }
+    count_chunk(&job[0]);
+    for (int k = 1; k < jobs; k++) {
+        if (job[k].threaded) {
+            pthread_join(tid[k], NULL);
+        } else {
+            count_chunk(&job[k]);
+        }
+    }
+
+    // Merge in file order
+    size_t carry = 0; // length of the line that is still open at the end of the previous chunk
+    int prev_in_word = 0;
+    for (int k = 0; k < jobs; k++) {
+        const struct wc_counts *c = &job[k].st.counts;
+        out->bytes += c->bytes;
+        out->lines += c->lines;
+        out->chars += c->chars;
+        out->words += c->words;
+        if (job[k].len == 0) {
+            continue; // nudged out of existence by the UTF-8 alignment
+        }
+        if (prev_in_word) {
+            int first_space = (flags & WC_USPACE) ? wc_uspace_at(job[k].buf, job[k].len)
+                                                  : space_table[job[k].buf[0]];
+            if (!first_space) {
+                out->words--; // one word split across the boundary was counted twice
+            }
+        }
+        prev_in_word = job[k].st.in_word;
+        if ((flags & WC_CHARS) && out->invalid_at == WC_UTF8_OK &&
+            job[k].st.utf8.first_invalid != WC_UTF8_OK) {
+            out->invalid_at = job[k].start + job[k].st.utf8.first_invalid;
+        }
+        if (flags & WC_MAXLINE) {
+            if (c->max_line > out->max_line) {
+                out->max_line = c->max_line;
+            }
+            if (job[k].has_newline) {
+                if (carry + job[k].head_len > out->max_line) {
+                    out->max_line = carry + job[k].head_len;
+                }
+                carry = job[k].st.line_len;
+            } else {
+                carry += job[k].head_len;
+            }
+        }
+    }
+    if (carry > out->max_line) {
+        out->max_line = carry;
+    }
+
+    free(job);
+    free(tid);
+    munmap(base, skip + size);
+    return 0;
+}
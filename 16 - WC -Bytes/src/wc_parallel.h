@@ -0,0 +1,13 @@
+#pragma once
+#include <stddef.h>
+#include "wc_core.h"
+
+// Regular files at least this big are worth splitting across threads
+#define WC_PARALLEL_MIN_SIZE ((size_t)8 * 1024 * 1024)
+
+// mmap a regular file and count it with `jobs` threads, one chunk each.
+// fd: open regular file, counted from byte `offset` (its current position, which
+// isn't 0 for a stdin someone already read from) for `size` bytes
+// returns: 0 on success, -1 if the file couldn't be mapped (caller should stream instead)
+int wc_count_mapped(int fd, size_t offset, size_t size, unsigned flags, int jobs,
+                    struct wc_counts *out);
@@ -0,0 +1,203 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "wc_simd.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define WC_HAVE_X86 1
+#endif
+
+// How the vector kernels count words without a per-byte branch:
+//
+// 1. Classify a block of 64 bytes at once into a bitmask, bit i = 1 if byte i is whitespace
+//    (' ' or 0x09..0x0D, i.e. isspace() in the C locale). For the range check we use
+//    (c - 9) <= 4 as an unsigned compare.
+// 2. A word starts at byte i when byte i is not space but byte i-1 is:
+//        starts = ~space & ((space << 1) | prev)
+//    where prev is 1 if the last byte of the previous block was space (or we weren't in a word).
+// 3. words += popcount(starts), lines += popcount(newline mask).
+//
+// The SSE2/AVX2/AVX-512 kernels only differ in how many loads it takes to build the
+// 64-bit masks. Leftover bytes (< 64) go through the scalar loop with the same state.
+
+enum { BLOCK = 64 };
+
+// Same table as wc_core.c: isspace() in the C locale
+static const unsigned char space_table[256] = {
+    ['\t'] = 1, ['\n'] = 1, ['\v'] = 1, ['\f'] = 1, ['\r'] = 1, [' '] = 1,
+};
+
+void wc_kernel_scalar(const unsigned char *buf, size_t n, int *in_word,
+                      size_t *words, size_t *lines) {
+    size_t w = 0, l = 0;
+    int iw = *in_word;
+    for (size_t i = 0; i < n; i++) {
+        unsigned char c = buf[i];
+        if (space_table[c]) {
+            iw = 0;
+        } else if (!iw) {
+            w++;
+            iw = 1;
+        }
+        l += (c == '\n');
+    }
+    *in_word = iw;
+    *words += w;
+    *lines += l;
+}
+
+#ifdef WC_HAVE_X86
+
+// Fold one block's masks into the running counts (shared by all vector kernels)
+static inline __attribute__((always_inline))
+void count_block(uint64_t space, uint64_t newline, uint64_t *prev_space,
+                 size_t *words, size_t *lines) {
+    uint64_t starts = ~space & ((space << 1) | *prev_space);
+    *words += (size_t)__builtin_popcountll(starts);
+    *lines += (size_t)__builtin_popcountll(newline);
+    *prev_space = space >> 63;
+}
+
+static inline __attribute__((always_inline))
+uint32_t sse2_space16(__m128i x) {
+    __m128i t = _mm_sub_epi8(x, _mm_set1_epi8(9));
+    __m128i ctrl = _mm_cmpeq_epi8(_mm_min_epu8(t, _mm_set1_epi8(4)), t); // 0x09..0x0D
+    __m128i sp = _mm_or_si128(ctrl, _mm_cmpeq_epi8(x, _mm_set1_epi8(' ')));
+    return (uint32_t)_mm_movemask_epi8(sp);
+}
+
+static inline __attribute__((always_inline))
+uint32_t sse2_newline16(__m128i x) {
+    return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(x, _mm_set1_epi8('\n')));
+}
+
+static void wc_kernel_sse2(const unsigned char *buf, size_t n, int *in_word,
+                           size_t *words, size_t *lines) {
+    uint64_t prev_space = !*in_word;
+    size_t w = 0, l = 0, i = 0;
+    for (; i + BLOCK <= n; i += BLOCK) {
+        uint64_t space = 0, newline = 0;
+        for (int k = 0; k < 4; k++) {
+            __m128i x = _mm_loadu_si128((const __m128i *)(buf + i + 16 * k));
+            space |= (uint64_t)sse2_space16(x) << (16 * k);
+            newline |= (uint64_t)sse2_newline16(x) << (16 * k);
+        }
+        count_block(space, newline, &prev_space, &w, &l);
+    }
+    int iw = !prev_space;
+    wc_kernel_scalar(buf + i, n - i, &iw, &w, &l);
+    *in_word = iw;
+    *words += w;
+    *lines += l;
+}
+
+__attribute__((target("avx2,popcnt")))
+static void wc_kernel_avx2(const unsigned char *buf, size_t n, int *in_word,
+                           size_t *words, size_t *lines) {
+    const __m256i nine = _mm256_set1_epi8(9);
+    const __m256i four = _mm256_set1_epi8(4);
+    const __m256i blank = _mm256_set1_epi8(' ');
+    const __m256i nl = _mm256_set1_epi8('\n');
+    uint64_t prev_space = !*in_word;
+    size_t w = 0, l = 0, i = 0;
+    for (; i + BLOCK <= n; i += BLOCK) {
+        uint64_t space = 0, newline = 0;
+        for (int k = 0; k < 2; k++) {
+            __m256i x = _mm256_loadu_si256((const __m256i *)(buf + i + 32 * k));
+            __m256i t = _mm256_sub_epi8(x, nine);
+            __m256i ctrl = _mm256_cmpeq_epi8(_mm256_min_epu8(t, four), t);
+            __m256i sp = _mm256_or_si256(ctrl, _mm256_cmpeq_epi8(x, blank));
+            space |= (uint64_t)(uint32_t)_mm256_movemask_epi8(sp) << (32 * k);
+            newline |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, nl)) << (32 * k);
+        }
+        count_block(space, newline, &prev_space, &w, &l);
+    }
+    int iw = !prev_space;
+    wc_kernel_scalar(buf + i, n - i, &iw, &w, &l);
+    *in_word = iw;
+    *words += w;
+    *lines += l;
+}
+
+__attribute__((target("avx512f,avx512bw,popcnt")))
+static void wc_kernel_avx512(const unsigned char *buf, size_t n, int *in_word,
+                             size_t *words, size_t *lines) {
+    const __m512i nine = _mm512_set1_epi8(9);
+    const __m512i four = _mm512_set1_epi8(4);
+    const __m512i blank = _mm512_set1_epi8(' ');
+    const __m512i nl = _mm512_set1_epi8('\n');
+    uint64_t prev_space = !*in_word;
+    size_t w = 0, l = 0, i = 0;
+    for (; i + BLOCK <= n; i += BLOCK) {
+        __m512i x = _mm512_loadu_si512((const void *)(buf + i));
+        uint64_t space = _mm512_cmple_epu8_mask(_mm512_sub_epi8(x, nine), four)
+                       | _mm512_cmpeq_epi8_mask(x, blank);
+        uint64_t newline = _mm512_cmpeq_epi8_mask(x, nl);
+        count_block(space, newline, &prev_space, &w, &l);
+    }
+    int iw = !prev_space;
+    wc_kernel_scalar(buf + i, n - i, &iw, &w, &l);
+    *in_word = iw;
+    *words += w;
+    *lines += l;
+}
+
+#endif // WC_HAVE_X86
+
+
+static wc_kernel_fn chosen_kernel;
+static const char *chosen_name;
+
+static void choose_kernel(void) {
+    const char *force = getenv("WC_KERNEL");
+    chosen_kernel = wc_kernel_scalar;
+    chosen_name = "scalar";
+#ifdef WC_HAVE_X86
+    __builtin_cpu_init();
+    int has_avx512 = __builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("popcnt");
+    int has_avx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt");
+    int has_sse2 = __builtin_cpu_supports("sse2");
+
+    if (force == NULL) {
+        if (has_avx512) {
+            chosen_kernel = wc_kernel_avx512;
+            chosen_name = "avx512";
+        } else if (has_avx2) {
+            chosen_kernel = wc_kernel_avx2;
+            chosen_name = "avx2";
+        } else if (has_sse2) {
+            chosen_kernel = wc_kernel_sse2;
+            chosen_name = "sse2";
+        }
+        return;
+    }
+    if (strcmp(force, "avx512") == 0 && has_avx512) {
+        chosen_kernel = wc_kernel_avx512;
+        chosen_name = "avx512";
+    } else if (strcmp(force, "avx2") == 0 && has_avx2) {
+        chosen_kernel = wc_kernel_avx2;
+        chosen_name = "avx2";
+    } else if (strcmp(force, "sse2") == 0 && has_sse2) {
+        chosen_kernel = wc_kernel_sse2;
+        chosen_name = "sse2";
+    } else if (strcmp(force, "scalar") != 0) {
+        fprintf(stderr, "WC_KERNEL=%s not available, using scalar\n", force);
+    }
+#else
+    (void)force;
+#endif
+}
+
+wc_kernel_fn wc_kernel(void) {
+    if (chosen_kernel == NULL) {
+        choose_kernel();
+    }
+    return chosen_kernel;
+}
+
+const char *wc_kernel_name(void) {
+    wc_kernel();
+    return chosen_name;
+}
@@ -0,0 +1,17 @@
+#pragma once
+#include <stddef.h>
+
+// Word + newline counting kernels.
+// A kernel counts the words that start in buf and the '\n' bytes in it, continuing from
+// *in_word (1 if the byte before buf was part of a word) and updating it for the next call.
+// Every kernel gives exactly the same results as wc_kernel_scalar.
+typedef void (*wc_kernel_fn)(const unsigned char *buf, size_t n, int *in_word,
+                             size_t *words, size_t *lines);
+
+void wc_kernel_scalar(const unsigned char *buf, size_t n, int *in_word,
+                      size_t *words, size_t *lines);
+
+// Best kernel for this CPU (chosen once via CPUID). WC_KERNEL=scalar|sse2|avx2|avx512
+// in the environment forces a specific one, e.g. to compare results.
+wc_kernel_fn wc_kernel(void);
+const char *wc_kernel_name(void);
@@ -0,0 +1,267 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "wc_utf8.h"
+#include "wc_simd.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define WC_HAVE_X86 1
+#endif
+
+// UTF-8 in one table (RFC 3629):
+//
+//   lead byte    continuation bytes   notes
+//   00..7F       -                    ASCII
+//   C2..DF       80..BF
+//   E0           A0..BF 80..BF        no overlong 3-byte forms
+//   E1..EC       80..BF 80..BF
+//   ED           80..9F 80..BF        no UTF-16 surrogates (D800..DFFF)
+//   EE..EF       80..BF 80..BF
+//   F0           90..BF 80..BF 80..BF no overlong 4-byte forms
+//   F1..F3       80..BF 80..BF 80..BF
+//   F4           80..8F 80..BF 80..BF nothing above U+10FFFF
+//   anything else is invalid (C0, C1, F5..FF, stray 80..BF)
+//
+// Only the first continuation byte has a special range, so the state is just
+// "how many more" plus the range for the next one.
+//
+// Speed: text is mostly ASCII. With SSE2 we test 64 bytes at a time (OR the four
+// loads, one movemask); if no byte has its top bit set and no sequence is open, the
+// whole block is valid and every byte is a character. Only blocks with non-ASCII
+// bytes take the byte-at-a-time state machine. Character counting itself is
+// vectorized too: a byte starts a character unless it's 80..BF, which as a signed
+// char is < -64.
+
+enum { BLOCK = 64 };
+
+void wc_utf8_init(struct wc_utf8 *u) {
+    memset(u, 0, sizeof(*u));
+    u->first_invalid = WC_UTF8_OK;
+}
+
+static void mark_invalid(struct wc_utf8 *u, size_t at) {
+    if (u->first_invalid == WC_UTF8_OK) {
+        u->first_invalid = at;
+    }
+}
+
+// Scalar state machine for n bytes at buf (which start at stream offset base).
+static void validate_scalar(struct wc_utf8 *u, const unsigned char *buf, size_t n, size_t base) {
+    for (size_t i = 0; i < n; i++) {
+        unsigned char c = buf[i];
+        if (u->need > 0) {
+            if (c >= u->lo && c <= u->hi) {
+                u->need--;
+                u->lo = 0x80;
+                u->hi = 0xBF;
+                continue;
+            }
+            // Sequence cut short; c itself gets a fresh look below
+            mark_invalid(u, u->seq_start);
+            u->need = 0;
+        }
+        if (c < 0x80) {
+            continue;
+        }
+        u->seq_start = base + i;
+        u->lo = 0x80;
+        u->hi = 0xBF;
+        if (c >= 0xC2 && c <= 0xDF) {
+            u->need = 1;
+        } else if (c >= 0xE0 && c <= 0xEF) {
+            u->need = 2;
+            if (c == 0xE0) u->lo = 0xA0;
+            if (c == 0xED) u->hi = 0x9F;
+        } else if (c >= 0xF0 && c <= 0xF4) {
+            u->need = 3;
+            if (c == 0xF0) u->lo = 0x90;
+            if (c == 0xF4) u->hi = 0x8F;
+        } else {
+            mark_invalid(u, base + i); // C0, C1, F5..FF or a stray continuation byte
+        }
+    }
+}
+
+static size_t count_chars_scalar(const unsigned char *buf, size_t n) {
+    size_t chars = 0;
+    for (size_t i = 0; i < n; i++) {
+        chars += (buf[i] & 0xC0) != 0x80;
+    }
+    return chars;
+}
+
+#ifdef WC_HAVE_X86
+
+// Bytes in a 64-byte block that are not continuation bytes
+static inline size_t count_chars64(const unsigned char *p) {
+    const __m128i limit = _mm_set1_epi8(-65); // 0xBF as signed
+    uint64_t starts = 0;
+    for (int k = 0; k < 4; k++) {
+        __m128i x = _mm_loadu_si128((const __m128i *)(p + 16 * k));
+        starts |= (uint64_t)(uint32_t)_mm_movemask_epi8(_mm_cmpgt_epi8(x, limit)) << (16 * k);
+    }
+    return (size_t)__builtin_popcountll(starts);
+}
+
+static inline int ascii64(const unsigned char *p) {
+    __m128i a = _mm_loadu_si128((const __m128i *)p);
+    __m128i b = _mm_loadu_si128((const __m128i *)(p + 16));
+    __m128i c = _mm_loadu_si128((const __m128i *)(p + 32));
+    __m128i d = _mm_loadu_si128((const __m128i *)(p + 48));
+    __m128i all = _mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d));
+    return _mm_movemask_epi8(all) == 0;
+}
+
+#else
+
+static inline size_t count_chars64(const unsigned char *p) {
+    return count_chars_scalar(p, BLOCK);
+}
+
+static inline int ascii64(const unsigned char *p) {
+    uint64_t acc = 0;
+    for (int k = 0; k < BLOCK / 8; k++) {
+        uint64_t w;
+        memcpy(&w, p + 8 * k, sizeof(w));
+        acc |= w;
+    }
+    return (acc & 0x8080808080808080ull) == 0;
+}
+
+#endif
+
+void wc_utf8_feed(struct wc_utf8 *u, const unsigned char *buf, size_t n) {
+    size_t base = u->offset;
+    size_t i = 0;
+    for (; i + BLOCK <= n; i += BLOCK) {
+        if (u->need == 0 && ascii64(buf + i)) {
+            u->chars += BLOCK; // pure ASCII, nothing open: valid, one char per byte
+            continue;
+        }
+        u->chars += count_chars64(buf + i);
+        validate_scalar(u, buf + i, BLOCK, base + i);
+    }
+    u->chars += count_chars_scalar(buf + i, n - i);
+    validate_scalar(u, buf + i, n - i, base + i);
+    u->offset += n;
+}
+
+void wc_utf8_finish(struct wc_utf8 *u) {
+    if (u->need > 0) {
+        mark_invalid(u, u->seq_start);
+        u->need = 0;
+    }
+}
+
+
+// ---- Unicode whitespace words ----
+
+// White_Space code points outside ASCII
+static int is_unicode_space(uint32_t cp) {
+    return cp == 0x85 || cp == 0xA0 || cp == 0x1680 ||
+           (cp >= 0x2000 && cp <= 0x200A) ||
+           cp == 0x2028 || cp == 0x2029 || cp == 0x202F || cp == 0x205F || cp == 0x3000;
+}
+
+static const unsigned char space_table[256] = {
+    ['\t'] = 1, ['\n'] = 1, ['\v'] = 1, ['\f'] = 1, ['\r'] = 1, [' '] = 1,
+};
+
+void wc_uwords_init(struct wc_uwords *w) {
+    memset(w, 0, sizeof(*w));
+}
+
+// Length of the ASCII run at the start of buf
+static size_t ascii_prefix(const unsigned char *buf, size_t n) {
+    size_t i = 0;
+    while (i + BLOCK <= n && ascii64(buf + i)) {
+        i += BLOCK;
+    }
+    while (i < n && buf[i] < 0x80) {
+        i++;
+    }
+    return i;
+}
+
+static inline void word_char(int is_space, int *in_word, size_t *words) {
+    if (is_space) {
+        *in_word = 0;
+    } else if (!*in_word) {
+        (*words)++;
+        *in_word = 1;
+    }
+}
+
+// ASCII runs go through the SIMD word kernel; only the non-ASCII bytes are decoded here.
+// A malformed sequence counts as one non-space character.
+void wc_uwords_feed(struct wc_uwords *w, const unsigned char *buf, size_t n,
+                    int *in_word, size_t *words, size_t *lines) {
+    wc_kernel_fn kernel = wc_kernel();
+    size_t i = 0;
+    while (i < n) {
+        if (w->need == 0) {
+            size_t run = ascii_prefix(buf + i, n - i);
+            if (run > 0) {
+                kernel(buf + i, run, in_word, words, lines);
+                i += run;
+                continue;
+            }
+        }
+        unsigned char c = buf[i++];
+        if (w->need > 0) {
+            if ((c & 0xC0) == 0x80) {
+                w->cp = (w->cp << 6) | (c & 0x3F);
+                if (--w->need == 0) {
+                    word_char(is_unicode_space(w->cp), in_word, words);
+                }
+                continue;
+            }
+            // cut short: the partial sequence was some non-space junk
+            w->need = 0;
+            word_char(0, in_word, words);
+            i--; // look at c again as a fresh byte
+            continue;
+        }
+        if (c < 0x80) {
+            word_char(space_table[c], in_word, words);
+            *lines += (c == '\n');
+        } else if (c >= 0xC0 && c <= 0xDF) {
+            w->cp = c & 0x1F;
+            w->need = 1;
+        } else if (c >= 0xE0 && c <= 0xEF) {
+            w->cp = c & 0x0F;
+            w->need = 2;
+        } else if (c >= 0xF0 && c <= 0xF7) {
+            w->cp = c & 0x07;
+            w->need = 3;
+        } else {
+            word_char(0, in_word, words); // stray continuation / invalid lead
+        }
+    }
+}
+
+// A sequence still open at the end of input is a (malformed) non-space character
+void wc_uwords_finish(struct wc_uwords *w, int *in_word, size_t *words) {
+    if (w->need > 0) {
+        w->need = 0;
+        word_char(0, in_word, words);
+    }
+}
+
+int wc_uspace_at(const unsigned char *p, size_t n) {
+    if (n == 0) {
+        return 0;
+    }
+    if (p[0] < 0x80) {
+        return space_table[p[0]];
+    }
+    struct wc_uwords w;
+    int in_word = 1; // so a non-space char doesn't count, a space char clears it
+    size_t words = 0, lines = 0;
+    wc_uwords_init(&w);
+    size_t len = (p[0] >= 0xF0) ? 4 : (p[0] >= 0xE0) ? 3 : 2;
+    wc_uwords_feed(&w, p, len < n ? len : n, &in_word, &words, &lines);
+    return !in_word;
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+#define WC_UTF8_OK SIZE_MAX   // first_invalid value when everything so far is valid
+
+// Streaming UTF-8 validator + code point counter.
+// Input can be fed in pieces; a sequence split across two pieces is handled.
+struct wc_utf8 {
+    size_t chars;           // code points (bytes that aren't 10xxxxxx continuation bytes)
+    size_t offset;          // bytes fed so far
+    size_t first_invalid;   // byte offset where the first bad sequence starts, or WC_UTF8_OK
+    size_t seq_start;       // offset of the lead byte of the open sequence
+    unsigned need;          // continuation bytes still expected
+    unsigned char lo, hi;   // allowed range for the next continuation byte
+};
+
+void wc_utf8_init(struct wc_utf8 *u);
+void wc_utf8_feed(struct wc_utf8 *u, const unsigned char *buf, size_t n);
+void wc_utf8_finish(struct wc_utf8 *u); // end of input: an unfinished sequence is invalid
+
+// Word counting that also treats Unicode whitespace (U+00A0, U+2000..U+200A, U+3000, ...)
+// as separators. Carries a partial sequence across calls like wc_utf8 does.
+struct wc_uwords {
+    uint32_t cp;            // code point being decoded
+    unsigned need;          // continuation bytes still expected
+};
+
+void wc_uwords_init(struct wc_uwords *w);
+void wc_uwords_feed(struct wc_uwords *w, const unsigned char *buf, size_t n,
+                    int *in_word, size_t *words, size_t *lines);
+void wc_uwords_finish(struct wc_uwords *w, int *in_word, size_t *words); // end of input
+
+// 1 if the character starting at p (n bytes available) is whitespace, ASCII or Unicode
+int wc_uspace_at(const unsigned char *p, size_t n);